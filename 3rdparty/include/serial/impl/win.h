@@ -72,6 +72,9 @@ public:
   bool
   isOpen () const;
 
+  int
+  native_handle () const;
+
   size_t
   available ();
   
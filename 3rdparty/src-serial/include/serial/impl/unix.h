@@ -83,6 +83,9 @@ public:
   bool
   isOpen () const;
 
+  int
+  native_handle () const;
+
   size_t
   available ();
 
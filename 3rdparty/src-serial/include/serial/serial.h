@@ -211,6 +211,14 @@ public:
   bool
   isOpen () const;
 
+  /*! Gets the native handle of the serial port, for polling it from outside.
+   *
+   * \return Returns the file descriptor on unix, -1 if the port is not open
+   * or the platform has no integer handle.
+   */
+  int
+  native_handle () const;
+
   /*! Closes the serial port. */
   void
   close ();
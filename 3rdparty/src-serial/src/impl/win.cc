@@ -299,6 +299,13 @@ Serial::SerialImpl::isOpen () const
   return is_open_;
 }
 
+int
+Serial::SerialImpl::native_handle () const
+{
+  // a HANDLE is not a file descriptor
+  return -1;
+}
+
 size_t
 Serial::SerialImpl::available ()
 {
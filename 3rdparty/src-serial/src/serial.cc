@@ -95,6 +95,12 @@ Serial::isOpen () const
   return pimpl_->isOpen ();
 }
 
+int
+Serial::native_handle () const
+{
+  return pimpl_->native_handle ();
+}
+
 size_t
 Serial::available ()
 {
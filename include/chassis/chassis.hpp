@@ -21,8 +21,11 @@ namespace Chassis
         ~Chassis() = default;
         // void update_data();
         void init(const std::shared_ptr<Robot::Robot_set>& robot);
-        void decomposition_speed(); //速度分解
-        [[noreturn]] void task();
+        void decomposition_speed(const Robot::Inputs& in); //速度分解
+        // one control period, run by the executor every ControlTime ms
+        void tick();
+        // one period of the power manager's RLS model and energy loop, every 1ms
+        void power_tick();
         void power_daemon(void* pvParam);
 
        public:
@@ -49,6 +52,8 @@ namespace Chassis
         // rad/s.底盘旋转角速度，逆时针为正
         fp32 wz = 0.f;
         fp32 wheel_speed[4] = {};
+        // 跟随的云台 (哨兵大 yaw 或 gimbalT_1) 的相对角，每个 tick 开头 load
+        fp32 gimbal_yaw_relative = 0.f;
 
         fp32 max_wheel_speed = 2.5f;
         ControllerList chassis_angle_pid;
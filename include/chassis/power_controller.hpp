@@ -151,7 +151,7 @@ namespace Power
         std::array<float, 4> getControlledOutput(PowerObj *objs[4]);
         void setMaxPowerConfigured(float maxPower);
         void setMode(uint8_t mode); //功率最大值设置
-        [[noreturn]] void powerDaemon (); //电源守护进程
+        void tick(); //电源守护进程的一个周期，由执行器每 1ms 调用
     };
 
 #define POWER_PD_KP 50.0f
@@ -6,6 +6,7 @@
 #include "gimbal/gimbal_config.hpp"
 #include "gimbal/gimbal_temp.hpp"
 #include "pid_controller.hpp"
+#include "rt_profile.hpp"
 #include "shoot_config.hpp"
 #include "types.hpp"
 
@@ -17,10 +18,72 @@ namespace Config
 
     const std::vector<std::string> SocketInitList = { "AUTO_AIM_CONTROL" };
 
+    // sockets whose same-host peer talks through POSIX shm (/gkd_<name>) instead of UDP
+    const std::vector<std::string> SocketShmList = {};
+
+    // 带时间戳的自瞄指令在同一时钟下 (同机 UDP 或 shm) 超过这个年龄就丢弃，不再当作新指令
+    constexpr uint32_t AUTO_AIM_MAX_AGE_MS = 50;
+
     const std::vector<std::tuple<std::string, int, int>> SerialInitList = {
         { "/dev/IMU_HERO", 115200, 2000 }
     };
 
+    // serial ports opened in low latency mode (ASYNC_LOW_LATENCY, input flushed)
+    const std::vector<std::string> SerialLowLatencyList = { "/dev/IMU_HERO" };
+
+    // 0: every IO device owns a blocking thread, N > 0: all devices share N epoll threads
+    constexpr int IO_REACTOR_WORKERS = 0;
+
+    // --rt-profile <name> / GKD_RT_PROFILE, 线程名见 Robot_ctrl 和 PeriodicExecutor
+    // rt: cpu0 留给系统、日志和UI，cpu1 IO 收发，cpu2 云台发弹和电机发送，cpu3 底盘功率和裁判系统
+    // fifo: 只设优先级不绑核，核数少的开发机上用
+    const std::vector<UserLib::RtProfile::Profile> RtProfiles = {
+        { .name = "rt",
+          .lock_memory = true,
+          .prefault_stack = 256 * 1024,
+          .threads = {
+            { "io", 80, 1 << 1 },
+            { "motor_tx", 79, 1 << 2 },
+            { "control", 79, 1 << 2 },
+            { "gimbal", 78, 1 << 2 },
+            { "shoot", 77, 1 << 2 },
+            { "chassis", 70, 1 << 3 },
+            { "power", 69, 1 << 3 },
+            { "referee", 50, 1 << 3 },
+            { "ui", 0, 1 << 0 },
+            { "logger", 0, 1 << 0 },
+            { "io_diag", 0, 1 << 0 },
+          } },
+        { .name = "fifo",
+          .lock_memory = true,
+          .prefault_stack = 256 * 1024,
+          .threads = {
+            { "io", 80 },
+            { "motor_tx", 79 },
+            { "control", 79 },
+            { "gimbal", 78 },
+            { "shoot", 77 },
+            { "chassis", 70 },
+            { "power", 69 },
+            { "referee", 50 },
+          } },
+    };
+
+    // CAN interfaces opened with CAN_RAW_FD_FRAMES (the bus must be configured for FD)
+    const std::vector<std::string> CanFdList = {};
+
+    // { can, bridge frame id }: send all DJI motor currents on that bus in one FD frame
+    const std::vector<std::tuple<std::string, uint32_t>> DJIMotorFdBridgeList = {};
+
+    // non-empty: every CAN interface records its traffic to <dir>/<name>.gkdtrace
+    const std::string CAN_CAPTURE_DIR = "";
+
+    // period of the CAN bus / serial link statistics pushed to Logger (debug builds)
+    constexpr uint32_t IO_DIAG_PERIOD_MS = 1000;
+
+    // a control loop tick longer than this share of its period counts as over_budget
+    constexpr uint32_t LOOP_BUDGET_PERCENT = 80;
+
     const std::string rc_controller_serial = "/dev/IMU_HERO";
     const std::string super_cap_can_interface = "CAN_CHASSIS";
 
@@ -217,6 +280,14 @@ namespace Config
     constexpr uint32_t CHASSIS_CONTROL_TIME = 2;
     constexpr uint32_t GIMBAL_CONTROL_TIME = 1;
     constexpr uint32_t SHOOT_CONTROL_TIME = 1;
+    // DJIMotorManager 的发送相位: 控制任务在每个周期开头计算，发送放在周期中间
+    constexpr uint32_t MOTOR_TX_PHASE_US = 500;
+
+    // true: 每个周期一个 control 任务，按 CAN 接收屏障 -> 各控制器 -> 电机发送 的顺序执行
+    // false: 各控制循环和电机发送是独立的执行器任务，靠相位错开
+    constexpr bool CONTROL_PIPELINE = false;
+    // 接收屏障最多等这么久，等不齐所有在线电机的新反馈就用现有数据计算
+    constexpr uint32_t PIPELINE_RX_TIMEOUT_US = 300;
 
     constexpr uint32_t DEFAULT_OFFLINE_TIME = 100;
 
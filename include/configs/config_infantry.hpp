@@ -6,6 +6,7 @@
 #include "gimbal/gimbal_config.hpp"
 #include "gimbal/gimbal_temp.hpp"
 #include "pid_controller.hpp"
+#include "rt_profile.hpp"
 #include "shoot_config.hpp"
 #include "types.hpp"
 
@@ -13,24 +14,91 @@ namespace Config
 {
     using GimbalType = Gimbal::GimbalT;
 
-    const std::vector<std::string> CanInitList = { "can1", "can0" };
+    // make sim: 同一套配置跑在 tools/plant_sim 提供的 vcan 和 PTY 上
+    const std::string CAN_CHASSIS = MUXDEF(CONFIG_SIM, "vcan1", "can1");
+    const std::string CAN_GIMBAL = MUXDEF(CONFIG_SIM, "vcan0", "can0");
+    const std::string IMU_SERIAL = MUXDEF(CONFIG_SIM, "/tmp/gkd_sim/IMU", "/dev/IMU_HERO");
+
+    const std::vector<std::string> CanInitList = { CAN_CHASSIS, CAN_GIMBAL };
 
     const std::vector<std::string> SocketInitList = { "AUTO_AIM_CONTROL" };
 
+    // sockets whose same-host peer talks through POSIX shm (/gkd_<name>) instead of UDP
+    const std::vector<std::string> SocketShmList = {};
+
+    // 带时间戳的自瞄指令在同一时钟下 (同机 UDP 或 shm) 超过这个年龄就丢弃，不再当作新指令
+    constexpr uint32_t AUTO_AIM_MAX_AGE_MS = 50;
+
     const std::vector<std::tuple<std::string, int, int>> SerialInitList = {
-        { "/dev/IMU_HERO", 115200, 2000 }
+        { IMU_SERIAL, 115200, 2000 }
+    };
+
+    // serial ports opened in low latency mode (ASYNC_LOW_LATENCY, input flushed)
+    const std::vector<std::string> SerialLowLatencyList = { IMU_SERIAL };
+
+    // 0: every IO device owns a blocking thread, N > 0: all devices share N epoll threads
+    constexpr int IO_REACTOR_WORKERS = 0;
+
+    // --rt-profile <name> / GKD_RT_PROFILE, 线程名见 Robot_ctrl 和 PeriodicExecutor
+    // rt: cpu0 留给系统、日志和UI，cpu1 IO 收发，cpu2 云台发弹和电机发送，cpu3 底盘功率和裁判系统
+    // fifo: 只设优先级不绑核，核数少的开发机上用
+    const std::vector<UserLib::RtProfile::Profile> RtProfiles = {
+        { .name = "rt",
+          .lock_memory = true,
+          .prefault_stack = 256 * 1024,
+          .threads = {
+            { "io", 80, 1 << 1 },
+            { "motor_tx", 79, 1 << 2 },
+            { "control", 79, 1 << 2 },
+            { "gimbal", 78, 1 << 2 },
+            { "shoot", 77, 1 << 2 },
+            { "chassis", 70, 1 << 3 },
+            { "power", 69, 1 << 3 },
+            { "referee", 50, 1 << 3 },
+            { "ui", 0, 1 << 0 },
+            { "logger", 0, 1 << 0 },
+            { "io_diag", 0, 1 << 0 },
+          } },
+        { .name = "fifo",
+          .lock_memory = true,
+          .prefault_stack = 256 * 1024,
+          .threads = {
+            { "io", 80 },
+            { "motor_tx", 79 },
+            { "control", 79 },
+            { "gimbal", 78 },
+            { "shoot", 77 },
+            { "chassis", 70 },
+            { "power", 69 },
+            { "referee", 50 },
+          } },
     };
 
-    const std::string rc_controller_serial = "/dev/IMU_HERO";
+    // CAN interfaces opened with CAN_RAW_FD_FRAMES (the bus must be configured for FD)
+    const std::vector<std::string> CanFdList = {};
 
-    const std::string super_cap_can_interface = "can1";
+    // { can, bridge frame id }: send all DJI motor currents on that bus in one FD frame
+    const std::vector<std::tuple<std::string, uint32_t>> DJIMotorFdBridgeList = {};
+
+    // non-empty: every CAN interface records its traffic to <dir>/<name>.gkdtrace
+    const std::string CAN_CAPTURE_DIR = "";
+
+    // period of the CAN bus / serial link statistics pushed to Logger (debug builds)
+    constexpr uint32_t IO_DIAG_PERIOD_MS = 1000;
+
+    // a control loop tick longer than this share of its period counts as over_budget
+    constexpr uint32_t LOOP_BUDGET_PERCENT = 80;
+
+    const std::string rc_controller_serial = IMU_SERIAL;
+
+    const std::string super_cap_can_interface = CAN_CHASSIS;
 
     const Chassis::ChassisConfig chassis_config = {
         .wheels_config = {
-            Hardware::DJIMotorConfig{3508, "can1", 1, 0.075},
-            Hardware::DJIMotorConfig{3508, "can1", 2, 0.075},
-            Hardware::DJIMotorConfig{3508, "can1", 3, 0.075},
-            Hardware::DJIMotorConfig{3508, "can1", 4, 0.075}
+            Hardware::DJIMotorConfig{3508, CAN_CHASSIS, 1, 0.075},
+            Hardware::DJIMotorConfig{3508, CAN_CHASSIS, 2, 0.075},
+            Hardware::DJIMotorConfig{3508, CAN_CHASSIS, 3, 0.075},
+            Hardware::DJIMotorConfig{3508, CAN_CHASSIS, 4, 0.075}
         },
         .chassis_follow_gimbal_pid_config = {
             .kp =           2.0f,
@@ -51,9 +119,9 @@ namespace Config
     };
 
     const Gimbal::GimbalConfig gimbal_config = {
-        .imu_serial_port = "/dev/IMU_HERO",
-        .yaw_motor_config = Hardware::DJIMotorConfig(6020, "can0", 1),
-        .pitch_motor_config = Hardware::DJIMotorConfig(6020, "can0", 2),
+        .imu_serial_port = IMU_SERIAL,
+        .yaw_motor_config = Hardware::DJIMotorConfig(6020, CAN_GIMBAL, 1),
+        .pitch_motor_config = Hardware::DJIMotorConfig(6020, CAN_GIMBAL, 2),
         .yaw_rate_pid_config = {
             .kp =           16668.f,
             .ki =           234.f,
@@ -98,9 +166,9 @@ namespace Config
         .ControlTime = 1,
         .YawOffSet = 2114,
         .shoot_config = {
-            .left_friction_motor_config = Hardware::DJIMotorConfig{3508, "can0", 1, 0.075},
-            .right_friction_motor_config = Hardware::DJIMotorConfig{3508, "can0", 2, 0.075},
-            .trigger_motor_config = Hardware::DJIMotorConfig{2006, "can0", 3, 0.075},
+            .left_friction_motor_config = Hardware::DJIMotorConfig{3508, CAN_GIMBAL, 1, 0.075},
+            .right_friction_motor_config = Hardware::DJIMotorConfig{3508, CAN_GIMBAL, 2, 0.075},
+            .trigger_motor_config = Hardware::DJIMotorConfig{2006, CAN_GIMBAL, 3, 0.075},
             .friction_speed_pid_config = Pid::PidConfig{
                 2000.f,       // KP
                 0.05f,     // KI
@@ -224,6 +292,14 @@ namespace Config
     constexpr uint32_t CHASSIS_CONTROL_TIME = 2;
     constexpr uint32_t GIMBAL_CONTROL_TIME = 1;
     constexpr uint32_t SHOOT_CONTROL_TIME = 1;
+    // DJIMotorManager 的发送相位: 控制任务在每个周期开头计算，发送放在周期中间
+    constexpr uint32_t MOTOR_TX_PHASE_US = 500;
+
+    // true: 每个周期一个 control 任务，按 CAN 接收屏障 -> 各控制器 -> 电机发送 的顺序执行
+    // false: 各控制循环和电机发送是独立的执行器任务，靠相位错开
+    constexpr bool CONTROL_PIPELINE = false;
+    // 接收屏障最多等这么久，等不齐所有在线电机的新反馈就用现有数据计算
+    constexpr uint32_t PIPELINE_RX_TIMEOUT_US = 300;
 
     constexpr uint32_t DEFAULT_OFFLINE_TIME = 100;
 
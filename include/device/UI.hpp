@@ -1,6 +1,8 @@
 #ifndef UI_HPP
 #define UI_HPP
 
+#include <functional>
+
 #include "device/referee/referee_base.hpp"
 #include "types.hpp"
 
@@ -360,7 +362,8 @@ typedef struct
     int fric_state;
 } State_Indicate_Type;
 
-void custom_ui_task(Device::Base *base_, uint8_t &robot_id_);
+// robot_id_ 每轮重新读取，裁判系统上线后才有正确的 id
+void custom_ui_task(Device::Base *base_, const std::function<uint8_t()> &robot_id_);
 extern void custom_UI_init(Device::Base *base_);
 extern UI_DisplayData_Type UI_Data;
 
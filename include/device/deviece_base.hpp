@@ -2,6 +2,8 @@
 #ifndef _DEVIECE_BASE_H
 #define _DEVIECE_BASE_H
 
+#include <atomic>
+
 #include "chrono"
 
 namespace Device
@@ -9,20 +11,24 @@ namespace Device
     class DeviceBase
     {
        public:
+        using time_point = typename std::chrono::steady_clock::time_point;
+
         explicit DeviceBase(uint32_t offline_time_t);
         explicit DeviceBase();
         bool offline() const;
+        // when the latest sample was taken (kernel receive time if the IO provides one)
+        time_point sample_time() const;
+        std::chrono::nanoseconds sample_age() const;
 
        protected:
         void update_time();
+        void update_time(time_point stamp);
 
        private:
-        using time_point = typename std::chrono::system_clock::time_point;
-        
-        time_point last_time;
+        std::atomic<time_point> last_time;
         uint32_t offline_time;
         
     };
 }  // namespace Device
 
-#endif
\ No newline at end of file
+#endif
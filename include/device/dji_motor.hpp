@@ -4,12 +4,14 @@
 
 #include <array>
 #include <cmath>
+#include <functional>
 #include <stdexcept>
 
 #include "device/deviece_base.hpp"
 #include "actuator.hpp"
 #include "can.hpp"
 #include "dji_motor.hpp"
+#include "topic.hpp"
 #include "types.hpp"
 
 namespace Hardware {
@@ -94,6 +96,7 @@ namespace Hardware {
             DJIMotorCanID can_id_ = DJIMotorCanID::ID_NULL;
             int data_bias = 0;
             int callback_flag = 0;
+            IO::Can_interface *can_ = nullptr;
         };
 
         Can_info can_info;
@@ -105,6 +108,9 @@ namespace Hardware {
         bool motor_enabled_ = false;
         int16_t give_current = 0;
 
+        // 每帧反馈，"motor.<can>.<反馈 id>"，enable() 之后才有
+        UserLib::Topic<Message> *feedback = nullptr;
+
         explicit DJIMotor(const DJIMotorConfig &config);
 
         template<typename ...Args>
@@ -115,7 +121,8 @@ namespace Hardware {
 
         explicit DJIMotor(DJIMotor &&other) = delete;
 
-        void unpack(const can_frame &frame);
+        // stamp: 内核收到该帧的时间
+        void unpack(const can_frame &frame, time_point stamp);
 
         void set(float x) override;
 
@@ -123,13 +130,33 @@ namespace Hardware {
     };
 
     namespace DJIMotorManager {
+        // 每个tick把一条总线上所有电机的give_current打包并发送
+        using Packer = std::function<void(IO::Can_interface &can, const std::vector<DJIMotor *> &motors)>;
+
         struct CanBlock {
             IO::Can_interface *can_ = nullptr;
             std::vector<DJIMotor *> motors_;
+            Packer packer_;
         };
 
+        // 默认: 0x1FF/0x200/0x2FF 三个标准帧，一次sendmmsg发出
+        extern void pack_classic(IO::Can_interface &can, const std::vector<DJIMotor *> &motors);
+
+        // 转接板协议: 三组8字节按 0x1FF/0x200/0x2FF 顺序拼成一个24字节的FD帧，ID为can_id
+        extern Packer fd_bridge_packer(uint32_t can_id);
+
+        extern void set_packer(const std::string &can_name, Packer packer);
+
         extern void register_motor(DJIMotor &motor);
 
-        extern void start();
+        // 发送一轮所有总线上的电流，由执行器每 1ms 调用
+        extern void tick();
+
+        // CAN 接收屏障: 等到每个在线电机都有 since 之后的反馈，超时返回 false
+        extern bool wait_feedback(
+            Device::DeviceBase::time_point since, std::chrono::nanoseconds timeout);
+
+        // 在线电机里最旧的一帧反馈的接收时间，没有在线电机时为 time_point{}
+        extern Device::DeviceBase::time_point oldest_feedback();
     }
 }
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <optional>
+
 #include "device/deviece_base.hpp"
 #include "memory"
+#include "quaternion.hpp"
 #include "robot.hpp"
+#include "topic.hpp"
 #include "types.hpp"
 
 namespace Device
@@ -10,6 +16,17 @@ namespace Device
     class IMU : public DeviceBase
     {
        public:
+        // 1 kHz 下约 512 ms，2 kHz 下约 256 ms
+        static constexpr size_t HISTORY = 512;
+
+        struct Attitude
+        {
+            time_point time;
+            UserLib::Quaternion q;
+            fp32 yaw, pitch, roll;
+            fp32 yaw_rate, pitch_rate, roll_rate;
+        };
+
         explicit IMU(const std::string& serial_name);
 
         fp32 yaw = 0;
@@ -21,9 +38,25 @@ namespace Device
 
         void enable();
         void unpack(const Types::ReceivePacket_IMU& pkg);
+        void unpack(const Types::ReceivePacket_IMU& pkg, time_point stamp);
+
+        /**
+         * t 时刻的姿态，由前后两个采样 slerp 插值 (角速度线性插值)，可以在任意线程调用
+         * t 比最新采样还新时返回最新采样 (不外推)，早于历史记录或还没有数据时返回 nullopt
+         */
+        std::optional<Attitude> attitude_at(time_point t) const;
+
+        using Topic = UserLib::Topic<Attitude, HISTORY>;
+        // "imu.<serial_name>"，只有串口线程发布
+        const Topic& topic() const {
+            return history;
+        }
 
        private:
+        bool read(uint64_t index, Attitude& out) const;
+
         std::string serial_name;
         std::shared_ptr<Robot::Robot_set> robot_set;
+        Topic& history;
     };
 }  // namespace Device
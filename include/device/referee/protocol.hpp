@@ -40,6 +40,7 @@
 #pragma once
 #define __packed __attribute__((packed))
 
+#include <cstddef>
 #include <cstdint>
 
 namespace Referee
@@ -748,4 +749,12 @@ namespace Referee
         0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330, 0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3,
         0x2c6a, 0x1ef1, 0x0f78
     };
+
+    // CRC16 over data with wCRC_table, continues from crc so a frame can be fed in pieces
+    inline uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc = kCrc16Init) {
+        while (len--) {
+            crc = (crc >> 8) ^ wCRC_table[(crc ^ *data++) & 0x00ff];
+        }
+        return crc;
+    }
 }  // namespace Referee
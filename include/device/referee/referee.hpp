@@ -6,6 +6,7 @@
 #include "device/deviece_base.hpp"
 #include "referee_base.hpp"
 #include "robot.hpp"
+#include "topic.hpp"
 
 namespace Device
 {
@@ -30,8 +31,32 @@ namespace Device
         int rx_len_;
 
        private:
+        template<typename T>
+        using Topic = UserLib::Topic<T>;
+        // 周期发送的数据 (最慢 1Hz)，超过这个时间没有收到就算过期
+        static constexpr std::chrono::seconds PERIODIC_MAX_AGE{ 2 };
+
         int unpack(uint8_t *rx_data);
         void publishCapacityData();
+        // 写进 referee_info 的对应字段，再原样发布到话题
+        template<typename T>
+        void receive(const uint8_t *data, T Types::Referee_info::*field, Topic<T> &topic);
+
+        Topic<Referee::GameStatus> &game_status_topic =
+            UserLib::topic_bus.topic<Referee::GameStatus>("referee.game_status", PERIODIC_MAX_AGE);
+        Topic<Referee::GameResult> &game_result_topic =
+            UserLib::topic_bus.topic<Referee::GameResult>("referee.game_result");
+        Topic<Referee::RefereeWarning> &warning_topic =
+            UserLib::topic_bus.topic<Referee::RefereeWarning>("referee.warning");
+        Topic<Referee::GameRobotStatus> &robot_status_topic =
+            UserLib::topic_bus.topic<Referee::GameRobotStatus>(
+                "referee.robot_status", PERIODIC_MAX_AGE);
+        Topic<Referee::PowerHeatData> &power_heat_topic =
+            UserLib::topic_bus.topic<Referee::PowerHeatData>(
+                "referee.power_heat", PERIODIC_MAX_AGE);
+        Topic<Referee::BulletAllowance> &bullet_allowance_topic =
+            UserLib::topic_bus.topic<Referee::BulletAllowance>(
+                "referee.bullet_allowance", PERIODIC_MAX_AGE);
 
         const int k_frame_length_ = 128, k_header_length_ = 5, k_cmd_id_length_ = 2,
                   k_tail_length_ = 2;
@@ -21,7 +21,7 @@ namespace Device
        public:
         void init(const std::string& can_name, const std::shared_ptr<Robot::Robot_set>& robot);
 
-        void unpack(const can_frame& frame);
+        void unpack(const can_frame& frame, time_point stamp);
         void set(bool enable, uint16_t power_limit);
     };
 }  // namespace Device
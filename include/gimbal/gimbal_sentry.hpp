@@ -13,7 +13,8 @@ namespace Gimbal
         ~GimbalSentry() = default;
         void init(const std::shared_ptr<Robot::Robot_set>& robot);
         void init_task();
-        [[noreturn]] void task();
+        // one control period, run by the executor every GIMBAL_CONTROL_TIME ms
+        void tick();
         void update_data();
 
        public:
@@ -32,7 +33,9 @@ namespace Gimbal
         fp32 yaw_relative_with_two_head = 0.f;
         fp32 yaw_gyro = 0.f;
         fp32 yaw_motor_speed = 0.f;
-        fp32* yaw_set;
+        // only this loop writes it, RC adds its yaw increments in ROBOT_SEARCH
+        fp32 yaw_set = 0.f;
+        Robot::RcInput rc_seen;
 
         int init_stop_times = 0;
     };
@@ -7,6 +7,8 @@
 #include "gimbal/gimbal_config.hpp"
 #include "robot.hpp"
 #include "shoot.hpp"
+#include "socket_interface.hpp"
+#include "topic.hpp"
 
 namespace Gimbal
 {
@@ -18,8 +20,11 @@ namespace Gimbal
         ~GimbalT() = default;
         void init(const std::shared_ptr<Robot::Robot_set>& robot);
         void init_task();
-        [[noreturn]] void task();
+        // one control period, run by the executor every ControlTime ms, shoot has its own
+        void tick();
         void update_data();
+        // 把 RC 和视觉各自发布的输入合并进本云台的设定值
+        void apply_inputs(const Robot::Inputs& in);
 
        public:
         uint32_t init_stop_times = 0;
@@ -28,12 +33,17 @@ namespace Gimbal
         fp32 pitch_gyro = 0.f;
         fp32 yaw_relative = 0.f;
         fp32 fake_yaw_abs;
+        // gimbal_sentry_state.yaw, loaded by update_data()
+        fp32 sentry_yaw = 0.f;
 
-        fp32* yaw_set;
-        fp32* another_yaw_set;
-        fp32* another_pitch_set;
-        fp32* pitch_set;
-        fp32* yaw_rela;
+        // only this gimbal's loop writes them
+        fp32 yaw_set = 0.f;
+        fp32 pitch_set = 0.f;
+        // inputs as of the previous apply_inputs()
+        Robot::RcInput rc_seen;
+        uint32_t vision_seen[2] = { 0, 0 };
+        // gimbal 2 only: gimbalT_1_state.rc_moves already copied
+        uint32_t rc_moves_seen = 0;
 
         std::shared_ptr<Robot::Robot_set> robot_set;
         GimbalConfig config;
@@ -49,7 +59,14 @@ namespace Gimbal
 
         Shoot::Shoot shoot;
 
-        std::chrono::_V2::steady_clock::time_point receive_auto_aim;
+        // resolved once in init, task() sends every tick
+        IO::Server_socket_interface* auto_aim_socket = nullptr;
+        IO::Server_socket_interface::Client auto_aim_client;
+
+        // 被采用的视觉指令 "vision.gimbal<id>"，Robot::VISION_TIMEOUT 没有新指令就算过期
+        // tick() 在 SendAutoAimInfo 里原样返回最新一条的 seq 和 sent_ns
+        UserLib::Topic<Robot::Auto_aim_control>* aim_topic = nullptr;
+        uint32_t aim_info_seq = 0;
 
     };
 
@@ -4,15 +4,26 @@
 #include <linux/can.h>
 #include <linux/can/raw.h>
 #include <net/if.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
+#include "can_trace.hpp"
+#include "histogram.hpp"
 #include "io_callback.hpp"
+#include "reactor.hpp"
 #include "types.hpp"
 
 namespace IO
@@ -20,19 +31,218 @@ namespace IO
     class Can_interface : public Callback_key<uint32_t, can_frame>
     {
        public:
-        Can_interface(const std::string &name);
+        // frames moved per recvmmsg/sendmmsg at most
+        static constexpr int MAX_BATCH = 32;
+        // distinct CAN IDs each TX priority class can hold
+        static constexpr int TX_QUEUE_DEPTH = 32;
+
+        // 发送优先级，队列满或总线忙时高优先级先发
+        enum class TxPriority : uint8_t
+        {
+            CONTROL = 0,  // 云台/底盘电流
+            DEVICE = 1,   // 超级电容、M9025等设备指令
+            DIAG = 2,     // 诊断
+        };
+        static constexpr int TX_CLASSES = 3;
+
+        struct Stats
+        {
+            std::atomic<uint64_t> rx_syscalls{ 0 };
+            std::atomic<uint64_t> rx_frames{ 0 };
+            std::atomic<uint64_t> tx_syscalls{ 0 };
+            std::atomic<uint64_t> tx_frames{ 0 };
+            // received frames that found a callback / found none (kernel filter miss)
+            std::atomic<uint64_t> delivered{ 0 };
+            std::atomic<uint64_t> unmatched{ 0 };
+            // frames received as canfd_frame (FD mode only)
+            std::atomic<uint64_t> rx_fd_frames{ 0 };
+            // frames sendmmsg rejected with a hard error, counted per frame
+            std::atomic<uint64_t> tx_failures{ 0 };
+            // queued frames replaced by a newer one with the same ID / refused by a full class
+            std::atomic<uint64_t> tx_coalesced{ 0 };
+            std::atomic<uint64_t> tx_dropped{ 0 };
+            // flushes stopped by EAGAIN/ENOBUFS
+            std::atomic<uint64_t> tx_backlogged{ 0 };
+            // CAN_ERR_FLAG frames, and the classes they reported
+            std::atomic<uint64_t> error_frames{ 0 };
+            std::atomic<uint64_t> bus_off{ 0 };
+            std::atomic<uint64_t> controller_errors{ 0 };
+            std::atomic<uint64_t> protocol_errors{ 0 };
+            // frames returned by each recvmmsg / handed to each sendmmsg
+            UserLib::Histogram rx_batch;
+            UserLib::Histogram tx_batch;
+            // kernel receive timestamp to callback, in ns
+            UserLib::Histogram rx_delay;
+        };
+
+        using time_point = std::chrono::steady_clock::time_point;
+        using FdFn = CanHandlerTable<canfd_frame>::Fn;
+        using Publish = std::function<void(const std::string &key, double value)>;
+
+        static constexpr uint32_t DEFAULT_BITRATE = 1000000;
+
+        struct ReplayResult
+        {
+            size_t frames = 0;
+            size_t delivered = 0;
+            double seconds = 0;
+        };
+
+        // offline: 不创建socket，只注册回调供 replay() 注入，所有发送都被拒绝
+        Can_interface(const std::string &name, bool offline = false);
         ~Can_interface();
-        bool send(const can_frame &frame);
+        /**
+         * 非阻塞发送: 帧先进入对应优先级的队列，同ID的旧帧被新帧原地替换，
+         * 随后立即尝试发送，发不出去的留到 POLLOUT 时再发
+         * 返回 false 表示帧被丢弃(队列已满、未开启FD或接口离线)
+         */
+        bool send(const can_frame &frame, TxPriority priority = TxPriority::DEVICE);
+        bool send(const canfd_frame &frame, TxPriority priority = TxPriority::DEVICE);
+        bool send_batch(
+            const can_frame *frames, size_t num, TxPriority priority = TxPriority::DEVICE);
         bool task();
         void init(const char *can_channel);
+        int fd() const;
+        uint32_t reactor_events() const;
+        void on_ready(uint32_t events);
+        // reactor mode: tx_event and the ENOBUFS retry timer get their own sources
+        void add_reactor_sources(Reactor &reactor);
+        const Stats &stats() const;
+        uint64_t filtered_frames() const;
+
+        /**
+         * 汇总上次调用以来的总线统计并逐项交给publish，只应在一个诊断线程中周期调用
+         * 总线: rx_fps tx_fps load(0~1) tx_fail err bus_off
+         * 批量收发: rx_syscalls tx_syscalls (次/s)，rx_batch/tx_batch 的 _p50 和 _max (帧/次)
+         * 内核收帧到回调的延迟: rx_delay_p50_us rx_delay_p99_us (启动以来)
+         * 每个注册的标准帧ID: 0x201.fps 0x201.jitter_us 0x201.max_gap_ms 0x201.age_ms
+         * load 由网卡 sysfs 的帧数和字节数按最坏位填充估算，包含被过滤掉的帧
+         */
+        void diagnostics(const Publish &publish);
+        void set_bitrate(uint32_t bitrate);
+        // kernel receive time of the frame being dispatched, only valid inside a callback
+        time_point rx_stamp() const;
+
+        // registering a key also lets its ID through the socket's CAN_RAW_FILTER
+        void register_callback_key(const uint32_t &key, Fn fn, void *ctx);
+        void register_callback_key(
+            const uint32_t &key, const std::function<void(const can_frame &)> &fun);
+
+        /**
+         * 打开CAN FD模式(CAN_RAW_FD_FRAMES)，之后同一个socket可以收发can_frame和canfd_frame
+         * 收到的FD帧交给register_fd_callback_key注册的回调，
+         * 没有FD回调且数据不超过8字节时，按普通can_frame交给register_callback_key的回调
+         */
+        bool enable_fd();
+        bool fd_enabled() const;
+        void register_fd_callback_key(uint32_t key, FdFn fn, void *ctx);
+
+        // 把收发的每一帧写入 .gkdtrace 文件
+        bool start_capture(const std::string &path);
+        void stop_capture();
+
+        /**
+         * 把抓包中收到的帧重新交给回调 (TX帧跳过)
+         * paced 为 true 时按原始时间间隔注入，否则尽快注入，用于测量回调链路的吞吐
+         * 回放时接口不应再被读取 (--can-replay 不启动接收)，rx_stamp() 为注入时刻
+         */
+        ReplayResult replay(CanTraceReader &trace, bool paced);
 
        private:
+        int receive(int flags);
+        bool dispatch(const canfd_frame &frame, bool is_fd);
+        bool enqueue(const canfd_frame &frame, bool is_fd, TxPriority priority);
+        void flush();
+        void arm_tx_retry();
+        void add_filter(uint32_t key);
+        void apply_filter();
+        uint64_t interface_rx_packets() const;
+        uint64_t interface_stat(const char *stat) const;
+        void record_arrival(uint32_t can_id, time_point stamp);
+        void record_error(const canfd_frame &frame);
+
         sockaddr_can *addr;
-        can_frame frame_r;
+        // sized for FD so that enabling FD never has to touch the rx buffers
+        canfd_frame rx_frames[MAX_BATCH];
+        iovec rx_iov[MAX_BATCH];
+        mmsghdr rx_msgs[MAX_BATCH];
+        char rx_control[MAX_BATCH][64];
+        time_point rx_stamp_;
+        // held per receive batch and per replayed frame: rx_stamp_ and the callbacks (with the
+        // topics they publish) only ever see one dispatching thread
+        std::mutex dispatch_lock;
+        Stats stats_;
+        std::mutex filter_lock;
+        std::vector<can_filter> filters;
+        uint64_t rx_packets_base = 0;
+        std::atomic<bool> fd_mode{ false };
+        CanHandlerTable<canfd_frame> fd_handlers;
+        std::atomic<CanTraceWriter *> capture{ nullptr };
+
+        // inter-arrival of each standard ID, reset by every diagnostics() window
+        struct IdTiming
+        {
+            std::atomic<int64_t> last_ns{ 0 };
+            std::atomic<uint64_t> gaps{ 0 };
+            std::atomic<uint64_t> gap_sum_us{ 0 };
+            std::atomic<uint64_t> gap_sq_sum_us{ 0 };
+            std::atomic<uint64_t> max_gap_us{ 0 };
+        };
+        std::unique_ptr<IdTiming[]> id_timing;
+
+        struct Window
+        {
+            time_point time;
+            uint64_t rx_frames = 0;
+            uint64_t tx_frames = 0;
+            uint64_t rx_syscalls = 0;
+            uint64_t tx_syscalls = 0;
+            uint64_t tx_failures = 0;
+            uint64_t error_frames = 0;
+            uint64_t bus_off = 0;
+            uint64_t if_packets = 0;
+            uint64_t if_bytes = 0;
+        };
+        Window last_window;
+
+        struct TxSlot
+        {
+            canfd_frame frame;
+            bool fd;
+        };
+
+        struct TxQueue
+        {
+            std::array<TxSlot, TX_QUEUE_DEPTH> slots;
+            size_t head = 0;
+            size_t size = 0;
+
+            TxSlot &at(size_t i) {
+                return slots[(head + i) % TX_QUEUE_DEPTH];
+            }
+        };
+
+        std::mutex tx_lock;
+        TxQueue tx_queues[TX_CLASSES];
+        // the last flush left frames queued, nobufs: because the device queue was full
+        std::atomic<bool> tx_backlog{ false };
+        std::atomic<bool> tx_nobufs{ false };
+        // signalled when a backlog starts or turns into ENOBUFS: wakes task() so it waits for
+        // POLLOUT or retries, in reactor mode its handler does the same through tx_retry
+        int tx_event = -1;
+        // reactor mode only: one-shot timerfd, ENOBUFS is not reported through EPOLLOUT
+        int tx_retry = -1;
+        // ENOBUFS retry period, task() polls with the same timeout
+        static constexpr int TX_RETRY_MS = 1;
+        uint32_t bitrate = DEFAULT_BITRATE;
+        // stopped writers stay alive, a sender may still hold the pointer
+        std::vector<std::unique_ptr<CanTraceWriter>> capture_writers;
         ifreq *ifr;
         Types::debug_info_t *debug;
         int soket_id;
         bool init_flag;
+        // no socket behind the interface, enqueue() refuses every frame
+        bool offline_mode;
 
        public:
         std::string name;
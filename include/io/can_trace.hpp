@@ -0,0 +1,97 @@
+#pragma once
+
+#include <linux/can.h>
+#include <net/if.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace IO
+{
+    /**
+     * CAN 抓包文件 (.gkdtrace)
+     * 文件头之后是连续的记录: 16字节的 CanTraceRecord + 按8字节对齐的数据，
+     * 时间戳为 CLOCK_MONOTONIC (ns)，可以直接 mmap 后顺序遍历
+     */
+    struct CanTraceHeader
+    {
+        static constexpr char MAGIC[8] = "GKDCANT";
+        static constexpr uint32_t VERSION = 1;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        char interface[IFNAMSIZ];
+        // realtime - monotonic when the capture started, to print wall clock stamps
+        int64_t realtime_offset_ns;
+    };
+
+    struct CanTraceRecord
+    {
+        static constexpr uint8_t TX = 1 << 0;
+        static constexpr uint8_t FD = 1 << 1;
+
+        uint64_t ts_ns;
+        uint32_t can_id;
+        uint8_t len;
+        uint8_t flags;
+        uint8_t fd_flags;  // canfd_frame::flags
+        uint8_t reserved;
+
+        static constexpr size_t data_size(uint8_t len) {
+            return (len + 7u) & ~7u;
+        }
+    };
+
+    static_assert(sizeof(CanTraceHeader) % 8 == 0);
+    static_assert(sizeof(CanTraceRecord) == 16);
+
+    class CanTraceWriter
+    {
+       public:
+        CanTraceWriter() = default;
+        ~CanTraceWriter();
+        CanTraceWriter(const CanTraceWriter &) = delete;
+        CanTraceWriter &operator=(const CanTraceWriter &) = delete;
+
+        bool open(const std::string &path, const std::string &interface);
+        void close();
+        // frame.len must not exceed CANFD_MAX_DLEN, classic frames share canfd_frame's layout
+        void write(uint64_t ts_ns, const canfd_frame &frame, bool fd, bool tx);
+        void write(uint64_t ts_ns, const can_frame &frame, bool tx);
+
+       private:
+        std::mutex lock;
+        FILE *file = nullptr;
+    };
+
+    class CanTraceReader
+    {
+       public:
+        struct Frame
+        {
+            uint64_t ts_ns;
+            bool tx;
+            bool fd;
+            canfd_frame frame;
+        };
+
+        CanTraceReader() = default;
+        ~CanTraceReader();
+        CanTraceReader(const CanTraceReader &) = delete;
+        CanTraceReader &operator=(const CanTraceReader &) = delete;
+
+        bool open(const std::string &path);
+        const CanTraceHeader &header() const;
+        // returns false at the end of the trace or on a truncated record
+        bool next(Frame &out);
+        void rewind();
+
+       private:
+        const uint8_t *base = nullptr;
+        size_t size = 0;
+        size_t offset = 0;
+    };
+}  // namespace IO
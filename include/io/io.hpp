@@ -1,11 +1,15 @@
 #pragma once
 
+#include <sys/epoll.h>
+
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <utils.hpp>
 
 #include "can.hpp"
+#include "reactor.hpp"
+#include "rt_profile.hpp"
 
 using CAN = IO::Can_interface;
 
@@ -17,6 +21,8 @@ namespace IO
        private:
         std::unordered_map<std::string, T *> data;
         std::vector<std::thread> io_handles;
+        Reactor *reactor_ = nullptr;
+        bool passive_ = false;
 
        public:
         ~IO() {
@@ -52,7 +58,45 @@ namespace IO
                 throw std::runtime_error("IO error: double register device named " + device.name);
             }
             p = &device;
-            io_handles.emplace_back(std::thread([&]() { device.task(); }));
+            if (passive_) {
+                return;
+            }
+            if (reactor_ != nullptr) {
+                // devices that queue output (CAN) also ask for EPOLLOUT
+                uint32_t events = EPOLLIN;
+                if constexpr (requires { device.reactor_events(); }) {
+                    events = device.reactor_events();
+                }
+                reactor_->add(
+                    device.name,
+                    device.fd(),
+                    [&](uint32_t ready) { device.on_ready(ready); },
+                    events);
+                // descriptors besides fd() (CAN: TX wakeup and retry timer)
+                if constexpr (requires { device.add_reactor_sources(*reactor_); }) {
+                    device.add_reactor_sources(*reactor_);
+                }
+            } else {
+                io_handles.emplace_back(std::thread([&]() { device.task(); }));
+                UserLib::rt_profile.apply("io", io_handles.back().native_handle());
+            }
+        }
+
+        template<typename F>
+        void for_each(F &&fn) const {
+            for (const auto &[name, device] : data) {
+                fn(*device);
+            }
+        }
+
+        // devices inserted afterwards are served by the reactor instead of their own thread
+        void use_reactor(Reactor &reactor) {
+            reactor_ = &reactor;
+        }
+
+        // devices inserted afterwards are never read, their callbacks only run from a replay
+        void passive() {
+            passive_ = true;
         }
     };
 
@@ -3,6 +3,16 @@
 //
 #pragma once
 
+#include <linux/can.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include "functional"
 #include "map"
 
@@ -122,4 +132,139 @@ namespace IO {
         std::map<Key, std::function<void(const Args &...)>> callback_map;
     };
 
+    /**
+     * 按CAN ID分发的回调表，can_frame 和 canfd_frame 共用，接收线程上最热的路径
+     * 11位标准帧ID直接查2048项的表，扩展帧或带标志位的ID在有序索引里二分查找
+     * 回调以 函数指针 + 上下文 的形式保存，分发时不查树、不加锁也不分配内存
+     * 注册可以和接收线程同时进行: 扩展帧索引每次注册复制一份再原子替换，
+     * 函数指针和上下文作为一个不可变的绑定整体发布，重复注册同一ID时换成新绑定
+     */
+    template<typename Frame>
+    class CanHandlerTable {
+       public:
+        using Fn = void (*)(void *ctx, const Frame &frame);
+
+        // returns false when no callback is registered for key
+        bool dispatch(uint32_t key, const Frame &frame) const {
+            const Handler *handler = find(key);
+            if (handler == nullptr) {
+                return false;
+            }
+            const Binding *binding = handler->binding.load(std::memory_order_acquire);
+            if (binding == nullptr) {
+                return false;
+            }
+            binding->fn(binding->ctx, frame);
+            return true;
+        }
+
+        void insert(uint32_t key, Fn fn, void *ctx) {
+            std::unique_lock guard(register_lock);
+            insert_locked(key, fn, ctx);
+        }
+
+        void insert(uint32_t key, const std::function<void(const Frame &)> &fun) {
+            std::unique_lock guard(register_lock);
+            auto &owned = functions.emplace_back(fun);
+            insert_locked(
+                key,
+                [](void *ctx, const Frame &frame) {
+                    (*static_cast<std::function<void(const Frame &)> *>(ctx))(frame);
+                },
+                &owned);
+        }
+
+       private:
+        // fn and ctx are only ever seen together, a binding is never changed once published
+        struct Binding
+        {
+            Fn fn;
+            void *ctx;
+        };
+
+        struct Handler
+        {
+            std::atomic<const Binding *> binding{ nullptr };
+        };
+
+        // extended IDs sorted by key, never changed once published
+        using ExtIndex = std::vector<std::pair<uint32_t, Handler *>>;
+
+        const Handler *find(uint32_t key) const {
+            if (key <= CAN_SFF_MASK) {
+                return &sff_table[key];
+            }
+            const ExtIndex *index = ext_index.load(std::memory_order_acquire);
+            if (index == nullptr) {
+                return nullptr;
+            }
+            auto p = std::lower_bound(
+                index->begin(), index->end(), key, [](const auto &entry, uint32_t k) {
+                    return entry.first < k;
+                });
+            return p == index->end() || p->first != key ? nullptr : p->second;
+        }
+
+        void insert_locked(uint32_t key, Fn fn, void *ctx) {
+            Handler *handler = key <= CAN_SFF_MASK ? &sff_table[key] : nullptr;
+            if (handler == nullptr) {
+                handler = const_cast<Handler *>(find(key));
+            }
+            if (handler == nullptr) {
+                handler = &ext_handlers.emplace_back();
+                ExtIndex index;
+                if (auto current = ext_index.load(std::memory_order_relaxed)) {
+                    index = *current;
+                }
+                index.insert(
+                    std::upper_bound(
+                        index.begin(),
+                        index.end(),
+                        key,
+                        [](uint32_t k, const auto &entry) { return k < entry.first; }),
+                    { key, handler });
+                // the previous index stays alive, the RX thread may still be searching it
+                ext_index.store(
+                    &ext_indexes.emplace_back(std::move(index)), std::memory_order_release);
+            }
+            // the replaced binding stays alive, the RX thread may be calling it right now
+            auto &binding = bindings.emplace_back(Binding{ fn, ctx });
+            handler->binding.store(&binding, std::memory_order_release);
+        }
+
+        std::array<Handler, CAN_SFF_MASK + 1> sff_table;
+        std::mutex register_lock;
+        // deques never move their elements: handlers, bindings, every published index and the
+        // std::function callbacks stay where the RX thread found them
+        std::deque<Handler> ext_handlers;
+        std::deque<Binding> bindings;
+        std::deque<ExtIndex> ext_indexes;
+        std::atomic<const ExtIndex *> ext_index{ nullptr };
+        std::deque<std::function<void(const Frame &)>> functions;
+    };
+
+    // CAN帧专用的Callback_key，保持和其它Callback_key相同的接口
+    template<>
+    class Callback_key<uint32_t, can_frame> {
+       public:
+        using Fn = CanHandlerTable<can_frame>::Fn;
+
+        // returns false when no callback is registered for key
+        bool callback_key(const uint32_t &key, const can_frame &frame) {
+            return handlers.dispatch(key, frame);
+        }
+
+        void register_callback_key(const uint32_t &key, Fn fn, void *ctx) {
+            handlers.insert(key, fn, ctx);
+        }
+
+        void register_callback_key(
+            const uint32_t &key, const std::function<void(const can_frame &)> &fun) {
+            handlers.insert(key, fun);
+        }
+
+       private:
+        CanHandlerTable<can_frame> handlers;
+    };
+
 }  // namespace Hardware
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "histogram.hpp"
+
+namespace IO
+{
+    /**
+     * 基于epoll的IO多路复用器，用少量线程代替每个设备一个阻塞线程的模式
+     * 设备以边沿触发(EPOLLET)的方式注册，因此handler每次被调用时必须读空当前可读的数据
+     */
+    class Reactor
+    {
+       public:
+        using Handler = std::function<void(uint32_t events)>;
+        using Publish = std::function<void(const std::string &key, double value)>;
+
+        struct Source
+        {
+            std::string name;
+            int fd = -1;
+            Handler handler;
+            // time from epoll_wait returning to the handler finishing, in ns
+            UserLib::Histogram dispatch_latency;
+        };
+
+        Reactor() = default;
+        ~Reactor();
+
+        void start(int worker_num);
+        bool running() const;
+        // events: EPOLLIN and/or EPOLLOUT, always registered edge triggered
+        void add(const std::string &name, int fd, Handler handler, uint32_t events);
+        // <source>.dispatch_p50/_p99/_max_us since start
+        void diagnostics(const Publish &publish) const;
+        // every source's dispatch latency, for the exit dump
+        void report() const;
+
+       private:
+        struct Worker
+        {
+            int epoll_fd = -1;
+            std::thread handle;
+        };
+
+        void run(Worker &worker);
+
+        mutable std::mutex lock;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::unique_ptr<Source>> sources;
+        size_t next_worker = 0;
+    };
+
+    inline Reactor reactor;
+}  // namespace IO
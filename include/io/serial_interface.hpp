@@ -1,9 +1,15 @@
 #ifndef __SERIAL_INTERFACE__
 #define __SERIAL_INTERFACE__
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <string>
 
+#include "histogram.hpp"
 #include "io_callback.hpp"
 #include "serial/serial.h"
+#include "serial_protocol.hpp"
 #include "types.hpp"
 #include "utils.hpp"
 
@@ -13,10 +19,56 @@ namespace IO
     class Serial_interface : serial::Serial, public Callback<Types::ReceivePacket_IMU, Types::ReceivePacket_RC_CTRL>
     {
        public:
-        Serial_interface(std::string port_name, int baudrate, int simple_timeout);
+        static constexpr size_t RX_BUFFER_SIZE = 4096;
+
+        // 接受哪种帧 (见 serial_protocol.hpp)
+        // AUTO 在收到第一帧校验通过的 V2 之前也接受 LEGACY，之后只认 V2，下位机可以逐块升级
+        enum class Framing
+        {
+            LEGACY,
+            V2,
+            AUTO,
+        };
+
+        struct Stats
+        {
+            std::atomic<uint64_t> rx_syscalls{ 0 };
+            std::atomic<uint64_t> rx_bytes{ 0 };
+            std::atomic<uint64_t> imu_frames{ 0 };
+            std::atomic<uint64_t> rc_frames{ 0 };
+            // bytes skipped while hunting for a frame header
+            std::atomic<uint64_t> resync_bytes{ 0 };
+            // times the parser lost sync after a good frame
+            std::atomic<uint64_t> resyncs{ 0 };
+            std::atomic<uint64_t> crc_failures{ 0 };
+            // frames missing according to the V2 sequence numbers
+            std::atomic<uint64_t> seq_gaps{ 0 };
+            // bytes returned by each read
+            UserLib::Histogram read_bytes;
+            // read that returned a frame's first byte to its callback returning, in ns
+            UserLib::Histogram rx_latency;
+        };
+
+        using Publish = std::function<void(const std::string &key, double value)>;
+
+        // low_latency: ASYNC_LOW_LATENCY, exact baudrate via termios2 and a flush of the stale
+        // input, see serial_tuning.hpp
+        Serial_interface(
+            std::string port_name, int baudrate, int simple_timeout, bool low_latency = false);
         Serial_interface() = delete;
         ~Serial_interface();
         void task();
+        int fd() const;
+        void on_ready(uint32_t events);
+        const Stats &stats() const;
+        // time the frame being dispatched was first seen, only valid inside a callback
+        std::chrono::steady_clock::time_point rx_stamp() const;
+        // call before the reader starts
+        void set_framing(Framing mode);
+        Framing framing() const;
+        // bytes_per_read fps imu_fps rc_fps resync_bytes resyncs crc_fail seq_gaps since the
+        // previous call, latency_p50_us latency_p99_us since start
+        void diagnostics(const Publish &publish);
         template<typename T>
         void send(T val) {
            write(&val, sizeof(T));
@@ -24,7 +76,17 @@ namespace IO
 
        private:
         inline void enumerate_ports();
-        inline int unpack(uint8_t pkg_id);
+        inline void unpack(uint8_t pkg_id, const uint8_t *payload);
+        void tune_low_latency(int baudrate);
+        // time of the read that returned the byte at rx_begin
+        std::chrono::steady_clock::time_point first_seen() const;
+        // one read of whatever is buffered, <0 with errno EAGAIN when nothing was
+        ssize_t read_chunk();
+        // dispatches every complete frame in rx_buffer and keeps the partial tail
+        void parse();
+        // drops n bytes at rx_begin that are not part of a valid frame
+        void skip(size_t n);
+        void check_seq(uint8_t pkg_id, uint8_t seq);
 
        public:
         Types::ReceivePacket_IMU imu_pkg;
@@ -32,8 +94,45 @@ namespace IO
         std::string name;
 
        private:
-        uint8_t buffer[256];
-        uint16_t header;
+        // frames are cut out of this buffer in place, no allocation per packet
+        uint8_t rx_buffer[RX_BUFFER_SIZE];
+        size_t rx_begin = 0;
+        size_t rx_end = 0;
+        // set by the first fd(), reads bypass serial::Serial once it is
+        mutable int native_fd = -1;
+
+        // end of each recent read in bytes since open, for first_seen()
+        struct ReadStamp
+        {
+            uint64_t end;
+            std::chrono::steady_clock::time_point time;
+        };
+        static constexpr size_t READ_STAMPS = 8;
+        ReadStamp read_stamps[READ_STAMPS]{};
+        uint64_t read_count = 0;
+        uint64_t rx_total = 0;
+        std::chrono::steady_clock::time_point rx_stamp_;
+
+        Framing framing_ = Framing::AUTO;
+        bool v2_seen = false;
+        bool in_sync = false;
+        // next expected V2 seq per packet id, -1 before the first frame
+        int16_t next_seq[SerialProtocol::MAX_ID + 1];
+        Stats stats_;
+
+        struct Window
+        {
+            std::chrono::steady_clock::time_point time;
+            uint64_t rx_syscalls = 0;
+            uint64_t rx_bytes = 0;
+            uint64_t imu_frames = 0;
+            uint64_t rc_frames = 0;
+            uint64_t resync_bytes = 0;
+            uint64_t resyncs = 0;
+            uint64_t crc_failures = 0;
+            uint64_t seq_gaps = 0;
+        };
+        Window last_window;
     };
 }  // namespace IO
 #endif
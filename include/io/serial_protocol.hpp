@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "protocol.hpp"
+#include "types.hpp"
+
+/**
+ * 下位机串口帧格式
+ *
+ * LEGACY: 0x55 0xAA id payload                       (无校验)
+ * V2:     0xA5 0x5A version id len seq payload crc16
+ *
+ * crc16 与裁判系统相同 (Referee::crc16)，覆盖 0xA5 到 payload 末尾，小端存放
+ * seq 每个 id 独立递增，用来统计丢帧
+ */
+namespace IO::SerialProtocol
+{
+    constexpr uint8_t LEGACY_SOF0 = 0x55;
+    constexpr uint8_t LEGACY_SOF1 = 0xAA;
+    constexpr size_t LEGACY_HEAD = 3;
+
+    constexpr uint8_t V2_SOF0 = 0xA5;
+    constexpr uint8_t V2_SOF1 = 0x5A;
+    constexpr uint8_t V2_VERSION = 2;
+    constexpr size_t V2_HEAD = 6;
+    constexpr size_t V2_TAIL = 2;
+
+    constexpr uint8_t IMU_ID = 1;
+    constexpr uint8_t RC_ID = 2;
+    constexpr size_t MAX_ID = RC_ID;
+
+    // payload length of a packet id, 0 for ids we don't know
+    constexpr size_t payload_size(uint8_t id) {
+        switch (id) {
+            case IMU_ID: return sizeof(Types::ReceivePacket_IMU);
+            case RC_ID: return sizeof(Types::ReceivePacket_RC_CTRL);
+            default: return 0;
+        }
+    }
+
+    constexpr size_t MAX_FRAME = V2_HEAD + sizeof(Types::ReceivePacket_IMU) +
+                                 sizeof(Types::ReceivePacket_RC_CTRL) + V2_TAIL;
+
+    // writes one frame into out (at least MAX_FRAME bytes), returns its length
+    inline size_t encode_legacy(uint8_t id, const void *payload, size_t len, uint8_t *out) {
+        out[0] = LEGACY_SOF0;
+        out[1] = LEGACY_SOF1;
+        out[2] = id;
+        std::memcpy(out + LEGACY_HEAD, payload, len);
+        return LEGACY_HEAD + len;
+    }
+
+    inline size_t encode_v2(
+        uint8_t id, uint8_t seq, const void *payload, size_t len, uint8_t *out) {
+        out[0] = V2_SOF0;
+        out[1] = V2_SOF1;
+        out[2] = V2_VERSION;
+        out[3] = id;
+        out[4] = static_cast<uint8_t>(len);
+        out[5] = seq;
+        std::memcpy(out + V2_HEAD, payload, len);
+        uint16_t crc = Referee::crc16(out, V2_HEAD + len);
+        out[V2_HEAD + len] = crc & 0xff;
+        out[V2_HEAD + len + 1] = crc >> 8;
+        return V2_HEAD + len + V2_TAIL;
+    }
+}  // namespace IO::SerialProtocol
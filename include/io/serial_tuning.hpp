@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * 串口驱动层的低延迟设置
+ * 实现里用的是 termios2 (asm/termbits.h)，它和 <termios.h> 不能出现在同一个编译单元，
+ * 所以这里只暴露按 fd 操作的函数
+ */
+namespace IO::SerialTuning
+{
+    // ASYNC_LOW_LATENCY: the driver hands every byte to the tty at once instead of batching
+    // (FTDI drops its latency timer to 1 ms). Fails on ports without TIOCSSERIAL, e.g. CDC-ACM
+    bool set_low_latency(int fd);
+    // exact baudrate through BOTHER, standard or not
+    bool set_baudrate(int fd, int baudrate);
+    // drops whatever the driver buffered before we opened the port
+    bool flush_input(int fd);
+}  // namespace IO::SerialTuning
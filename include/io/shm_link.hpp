@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace IO
+{
+    /**
+     * 同机进程间的共享内存链路 (POSIX shm)，用来替代到 127.0.0.1 的 UDP
+     * 每个 header 占一个通道，通道里两个方向各有一个单生产者单消费者的环形队列
+     * 接收方没有数据时睡在 futex 上，发送方只在对方确实在睡时才发起 FUTEX_WAKE
+     */
+    class ShmRing
+    {
+       public:
+        static constexpr uint32_t SLOTS = 64;
+        static constexpr uint32_t SLOT_SIZE = 256;
+
+        // false when the ring is full or len > SLOT_SIZE, producer side only
+        bool push(const void *data, uint32_t len);
+
+        // hands the oldest message to fn in place, consumer side only
+        template<typename F>
+        bool pop(F &&fn) {
+            uint32_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == head_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            const auto &slot = slots[tail % SLOTS];
+            fn(slot.data, slot.len);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+       private:
+        struct Slot
+        {
+            uint32_t len;
+            uint8_t data[SLOT_SIZE];
+        };
+
+        alignas(64) std::atomic<uint32_t> head_;
+        alignas(64) std::atomic<uint32_t> tail_;
+        alignas(64) Slot slots[SLOTS];
+    };
+
+    // futex word shared by both processes, one per receiving side
+    struct ShmDoorbell
+    {
+        std::atomic<uint32_t> seq;
+        std::atomic<uint32_t> sleepers;
+
+        void ring();
+        // returns once seq moved past seen or after timeout
+        void wait(uint32_t seen, std::chrono::microseconds timeout);
+    };
+
+    struct ShmSegment
+    {
+        static constexpr char MAGIC[8] = "GKDSHM";
+        static constexpr uint32_t VERSION = 1;
+        static constexpr size_t MAX_CHANNELS = 8;
+
+        struct Channel
+        {
+            // 0: free, header + 1 once claimed
+            std::atomic<uint32_t> owner;
+            ShmRing to_robot;
+            ShmRing to_vision;
+        };
+
+        char magic[8];
+        uint32_t version;
+        ShmDoorbell robot_bell;
+        ShmDoorbell vision_bell;
+        Channel channels[MAX_CHANNELS];
+    };
+
+    class ShmLink
+    {
+       public:
+        enum class Side
+        {
+            ROBOT,
+            VISION,
+        };
+
+        ShmLink() = default;
+        ~ShmLink();
+        ShmLink(const ShmLink &) = delete;
+        ShmLink &operator=(const ShmLink &) = delete;
+
+        // ROBOT creates the segment (and resets it), VISION attaches to an existing one
+        bool open(const std::string &name, Side side);
+        // the ring this side sends header on, claims a channel on first use; nullptr when full
+        ShmRing *tx_ring(uint8_t header);
+        // push and wake the peer if it sleeps, one sending thread per ring
+        bool send(ShmRing *ring, const void *data, uint32_t len);
+
+        // drains every channel towards this side, fn(const uint8_t *data, uint32_t len)
+        template<typename F>
+        size_t poll(F &&fn) {
+            size_t n = 0;
+            for (auto &channel : segment->channels) {
+                if (channel.owner.load(std::memory_order_acquire) == 0) {
+                    continue;
+                }
+                auto &ring = side == Side::ROBOT ? channel.to_robot : channel.to_vision;
+                while (ring.pop(fn)) {
+                    n++;
+                }
+            }
+            return n;
+        }
+
+        // sleeps until the peer sends something, call when poll() returned 0
+        void wait(std::chrono::microseconds timeout);
+
+       private:
+        ShmDoorbell &rx_bell();
+        ShmDoorbell &tx_bell();
+
+        ShmSegment *segment = nullptr;
+        Side side = Side::ROBOT;
+        uint32_t rx_seen = 0;
+    };
+}  // namespace IO
@@ -5,12 +5,20 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
-#include <map>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
 
+#include "histogram.hpp"
 #include "io_callback.hpp"
 #include "robot.hpp"
+#include "shm_link.hpp"
 #include "utils.hpp"
 
 namespace IO
@@ -19,35 +27,134 @@ namespace IO
 
     {
        public:
-        Server_socket_interface(std::string name);
+        static constexpr size_t MAX_BATCH = 16;
+        static constexpr size_t MAX_DATAGRAM = 256;
+
+        // 发送目标，由 add_client 提前解析好，发送时不再按 header 查找
+        // 共享内存模式下直接指向该 header 的发送队列
+        class Client
+        {
+           public:
+            Client() = default;
+            explicit operator bool() const {
+                return addr != nullptr || ring != nullptr;
+            }
+
+           private:
+            friend class Server_socket_interface;
+            explicit Client(const sockaddr_in *addr, ShmRing *ring = nullptr)
+                : addr(addr),
+                  ring(ring) {
+            }
+            const sockaddr_in *addr = nullptr;
+            ShmRing *ring = nullptr;
+        };
+
+        struct Stats
+        {
+            std::atomic<uint64_t> rx_packets{ 0 };
+            std::atomic<uint64_t> tx_packets{ 0 };
+            // sendto/sendmmsg errors or a full shm ring, replaces the per-packet LOG_ERR
+            std::atomic<uint64_t> tx_failures{ 0 };
+            // send(pkg) with a header nobody registered
+            std::atomic<uint64_t> tx_unknown{ 0 };
+            // datagrams returned by each recvmmsg
+            UserLib::Histogram rx_batch;
+            // 带时间戳的 Auto_aim_control, ns: 发送到分发 (仅同一时钟) 与 SendAutoAimInfo 往返
+            UserLib::Histogram aim_one_way;
+            UserLib::Histogram aim_rtt;
+            // older than the max command age, never handed to the callbacks
+            std::atomic<uint64_t> aim_stale{ 0 };
+        };
+
+        using Publish = std::function<void(const std::string &key, double value)>;
+
+        // shm: serve the same-host peer through the POSIX shm segment /gkd_<name>, every send
+        // goes through its rings, datagrams arriving on the UDP port are still dispatched
+        explicit Server_socket_interface(std::string name, bool shm = false);
         ~Server_socket_interface();
         void task();
-        void add_client(uint8_t header, std::string ip, int port);
+        int fd() const;
+        void on_ready(uint32_t events);
+        Client add_client(uint8_t header, std::string ip, int port);
+        // the address registered for header, empty until add_client or its first datagram
+        Client client(uint8_t header) const;
+        const Stats &stats() const;
+        // 0 disables the check, see check_command
+        void set_max_command_age(std::chrono::nanoseconds age);
+        // rx_pps tx_pps tx_fail tx_unknown aim_stale since the previous call,
+        // aim_one_way / aim_rtt p50 p99 in us since start
+        void diagnostics(const Publish &publish);
 
         template<typename T>
         void send(const T &pkg) {
             uint8_t header = *(uint8_t *)(&pkg);
-            // LOG_INFO("header %d client: %d\n", header, clients.find(header)->second.sin_addr.s_addr);
-            auto n = sendto(
-                sockfd,
-                (const char *)(&pkg),
-                sizeof(pkg),
-                MSG_CONFIRM,
-                (const struct sockaddr *)&clients.find(header)->second,
-                sizeof(clients.find(header)->second));
-            if(n == -1) {
-                LOG_ERR("error socket send");
-            }  
+            auto target = client(header);
+            if (!target) {
+                stats_.tx_unknown.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            send(target, pkg);
+        }
+
+        template<typename T>
+        void send(Client target, const T &pkg) {
+            send_raw(target, &pkg, sizeof(pkg));
+        }
+
+        // the same datagram to every target with one sendmmsg
+        template<typename T>
+        void fan_out(std::span<const Client> targets, const T &pkg) {
+            fan_out_raw(targets, &pkg, sizeof(pkg));
         }
 
        private:
+        struct Target
+        {
+            sockaddr_in addr;
+            std::atomic<bool> valid{ false };
+        };
+
+        int receive(int flags);
+        // from is nullptr for shm messages
+        void dispatch(const uint8_t *data, size_t len, const sockaddr_in *from);
+        // records the latencies of a stamped command, false when it is too old to act on
+        bool check_command(const Robot::Auto_aim_control &vc, const sockaddr_in *from);
+        void shm_task();
+        void register_client(uint8_t header, const sockaddr_in &addr);
+        void send_raw(Client target, const void *data, size_t len);
+        void fan_out_raw(std::span<const Client> targets, const void *data, size_t len);
+
         int64_t port_num;
         int sockfd;
 
         sockaddr_in serv_addr;
-        std::map<uint8_t, sockaddr_in> clients;
+        // indexed by header, an address never changes once valid so senders read it unlocked
+        std::array<Target, 256> clients;
+        std::mutex register_lock;
+        // UDP and shm_task both dispatch, callbacks and the topics they publish see one at a time
+        std::mutex dispatch_lock;
+
+        uint8_t rx_buffers[MAX_BATCH][MAX_DATAGRAM];
+        sockaddr_in rx_names[MAX_BATCH];
+        iovec rx_iov[MAX_BATCH];
+        mmsghdr rx_msgs[MAX_BATCH];
+
+        Stats stats_;
+        std::atomic<uint64_t> max_command_age_ns{ 0 };
+
+        std::unique_ptr<ShmLink> shm;
 
-        char buffer[256];
+        struct Window
+        {
+            std::chrono::steady_clock::time_point time;
+            uint64_t rx_packets = 0;
+            uint64_t tx_packets = 0;
+            uint64_t tx_failures = 0;
+            uint64_t tx_unknown = 0;
+            uint64_t aim_stale = 0;
+        };
+        Window last_window;
 
        public:
         std::string name;
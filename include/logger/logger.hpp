@@ -149,13 +149,18 @@ public:
 
     void push_value(const std::string& name,double value){
         uint32_t hash = string_hash(name);
+        auto update = LogUpdateValueMessage::build(hash,value);
 
-        if(!_registered_names.contains(name)){
-            push_message<LogRegisterNameMessage>(hash,name);
-            _registered_names.insert(name);
+        // 控制循环和诊断线程都会调用，名字集合和队列在同一把锁下，注册消息一定先于数值入队
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if(_registered_names.insert(name).second){
+                _q.push(LogRegisterNameMessage::build(hash,name));
+            }
+            _q.push(std::move(update));
         }
 
-        push_message<LogUpdateValueMessage>(hash,value);
+        _cv.notify_one();
     }
 
     // TODO
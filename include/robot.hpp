@@ -1,20 +1,162 @@
 #ifndef __ROBOT__
 #define __ROBOT__
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "seqlock.hpp"
 #include "types.hpp"
 
 namespace Robot
 {
-    // robot set header = 0xEA;
-    struct Robot_set
+    // 按写者分块，每块独占 cache line，一个线程的写不会让其他核正在读的数据失效
+    inline constexpr size_t CACHE_LINE = 64;
+
+    // 自瞄指令中断超过这个时间，视觉给的开火失效，这个云台的射击权限 (RC 给的也算) 被清掉
+    inline constexpr auto VISION_TIMEOUT = std::chrono::milliseconds(300);
+
+    inline int64_t input_now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // 操作手输入，只由 RC 回调写
+    struct RcInput
     {
-        uint8_t header;
-        /** chassis_control **/
         fp32 vx_set = 0.f;
         fp32 vy_set = 0.f;
         fp32 wz_set = 0.f;
-        bool spin_state = false;
+        bool friction_open = false;
+        bool auto_aim_status = false;
+        uint8_t sentry_follow_gimbal = 0;
+        int shoot_open = 0;
+        // 云台的手动增量只累加，云台循环把相邻两次 load 的差叠加到设定值上
+        // yaw 在 ROBOT_SEARCH 时给哨兵大 yaw，其他模式给云台 1，哨兵的云台 2 照搬云台 1
+        fp32 yaw_offset = 0.f;
+        fp32 pitch_offset = 0.f;
+        // 摇杆直接给出的 pitch，这一包有效时代替 pitch_offset
+        bool pitch_absolute = false;
+        fp32 pitch_set = 0.f;
+        uint32_t packets = 0;
+    };
+
+    // 自瞄输入，每个云台的视觉回调只写自己那一份
+    struct VisionInput
+    {
+        // fire 指令的条数，云台循环看到它变了就采用 yaw_set / pitch_set
+        uint32_t commands = 0;
+        fp32 yaw_set = 0.f;
+        fp32 pitch_set = 0.f;
+        // 这一串连续指令里出现过 fire，指令中断超过 VISION_TIMEOUT 后重新计
+        bool firing = false;
+        // 最新一条指令到达的时间，input_now_ns()
+        int64_t stamp_ns = 0;
+    };
+
+    // 云台状态，每个云台循环只写自己那一份
+    struct GimbalState
+    {
+        fp32 yaw = 0.f;
+        fp32 yaw_relative = 0.f;
+        // 云台 1 最近一次 RC 移动后的设定值，rc_moves 每次移动加一，哨兵的云台 2 照搬
+        fp32 yaw_set = 0.f;
+        fp32 pitch_set = 0.f;
+        uint32_t rc_moves = 0;
+    };
+
+    /**
+     * 一个 tick 的输入快照: 各循环开头 Robot_set::inputs() 取一次，整个 tick 用同一份
+     * RC 和视觉以前写同一批字段，现在各自发布，合并规则都在这里
+     */
+    struct Inputs
+    {
+        RcInput rc;
+        VisionInput vision[2];
+        Types::ROBOT_MODE base_mode;
+        // sentry only: the referee reports the game running
+        bool game_started;
+        int64_t now_ns;
+
+        // gimbal_id 1 或 2: 视觉的指令还没有中断，开不开火都算
+        bool vision_online(int gimbal_id) const {
+            return now_ns - vision[gimbal_id - 1].stamp_ns <
+                   std::chrono::nanoseconds(VISION_TIMEOUT).count();
+        }
+
+        // 视觉开过火，指令也还没有中断
+        bool aiming(int gimbal_id) const {
+            return vision[gimbal_id - 1].firing && vision_online(gimbal_id);
+        }
+
+        bool cv_fire() const {
+            return aiming(1) || aiming(2);
+        }
+
+        // RC 给的射击权限，哨兵的每个云台自瞄开火时再加上自己那一位
+        // 所有车型: 某个云台的视觉指令中断后，它那一位被清掉
+        int shoot_open() const {
+            int open = rc.shoot_open;
+            for (int id = 1; id <= 2; id++) {
+                if (ISDEF(CONFIG_SENTRY) && aiming(id)) {
+                    open |= id;
+                }
+                if (!vision_online(id)) {
+                    open &= ~id;
+                }
+            }
+            return open;
+        }
+
+        // 哨兵: 跟随云台或有射击权限时 FOLLOW_GIMBAL，否则 SEARCH
+        Types::ROBOT_MODE mode() const {
+            if (!ISDEF(CONFIG_SENTRY) || base_mode == Types::ROBOT_MODE::ROBOT_NO_FORCE) {
+                return base_mode;
+            }
+            return rc.sentry_follow_gimbal || shoot_open() != 0
+                       ? Types::ROBOT_MODE::ROBOT_FOLLOW_GIMBAL
+                       : Types::ROBOT_MODE::ROBOT_SEARCH;
+        }
+
+        // 哨兵开赛后自己转起来并打开摩擦轮
+        fp32 wz_set() const {
+            return ISDEF(CONFIG_SENTRY) && game_started ? 0.3f : rc.wz_set;
+        }
+
+        bool friction_open() const {
+            return rc.friction_open || (ISDEF(CONFIG_SENTRY) && game_started);
+        }
+    };
+
+    // robot set header = 0xEA;
+    struct Robot_set
+    {
+        /** 操作手 / 自瞄输入: 各由一个回调整块发布，循环通过 inputs() 读 **/
+        alignas(CACHE_LINE) UserLib::SeqLock<RcInput> rc;
+        alignas(CACHE_LINE) UserLib::SeqLock<VisionInput> vision_gimbal1;
+        alignas(CACHE_LINE) UserLib::SeqLock<VisionInput> vision_gimbal2;
+
+        /** 云台状态: 各云台循环每个 tick 发布，底盘和其他云台读 **/
+        alignas(CACHE_LINE) UserLib::SeqLock<GimbalState> gimbalT_1_state;
+        alignas(CACHE_LINE) UserLib::SeqLock<GimbalState> gimbalT_2_state;
+        alignas(CACHE_LINE) UserLib::SeqLock<GimbalState> gimbal_sentry_state;
+
+        /** 模式: 初始化完成后 main 设置一次 **/
+        alignas(CACHE_LINE) std::atomic<Types::ROBOT_MODE> mode =
+            Types::ROBOT_MODE::ROBOT_NO_FORCE;
+        std::atomic<Types::ROBOT_MODE> last_mode = Types::ROBOT_MODE::ROBOT_NO_FORCE;
+
+        /** 发射/底盘状态: 各自的循环写，裁判系统 UI 读 **/
+        alignas(CACHE_LINE) bool friction_real_state =
+            false;  // friction's real state (motor linear speed < 0.5 ? false : true)
+
+        alignas(CACHE_LINE) bool spin_state = false;
+
+        /** 冷数据: 只在初始化时写，或没有使用 **/
+        alignas(CACHE_LINE) uint8_t inited = 0;
+        uint8_t header;
 
-        /** gimbal_control **/
         fp32 gimbal1_yaw_set = 0.f;
         fp32 gimbal1_yaw_offset = 0.f;
         fp32 gimbal1_pitch_set = 0.f;
@@ -27,51 +169,46 @@ namespace Robot
         fp32 gimbal3_yaw_offset = 0.f;
         fp32 gimbal3_pitch_set = 0.f;
 
-        /** shoot_control **/
-        bool friction_open = false;
-        bool friction_real_state =
-            false;  // friction's real state (motor linear speed < 0.5 ? false : true)
-        bool cv_fire = false;
-        int shoot_open = 0;
-
-        /** other **/
-        fp32 gimbalT_1_yaw_set = 0.f;
-        fp32 gimbalT_1_pitch_set = 0.f;
-        fp32 gimbalT_1_yaw_reletive = 0.f;
-
-        // only sentry needs gimbalT_2
-        fp32 gimbalT_2_yaw_set = 0.f;
-        fp32 gimbalT_2_pitch_set = 0.f;
-        fp32 gimbalT_2_yaw_reletive = 0.f;
-
-        fp32 gimbal_sentry_yaw_set = 0.f;
-        fp32 gimbal_sentry_yaw = 0.f;
-        fp32 gimbal_sentry_yaw_reletive = 0.f;
-
         fp32 aimx;
         fp32 aimy;
         fp32 aimz;
         bool is_aiming = false;
-        uint8_t inited = 0;
 
-        uint8_t sentry_follow_gimbal = 0;
+        /** 裁判系统 / 功率: 整块由一个线程写入 **/
+        // super_cap_info <- Super_Cap::unpack (CAN 回调), referee_info <- 裁判系统线程
+        // 读者每个 tick load() 一次，拿到的是同一帧的数据
+        alignas(CACHE_LINE) UserLib::SeqLock<Types::ReceivePacket_Super_Cap> super_cap_info;
+        alignas(CACHE_LINE) UserLib::SeqLock<Types::Referee_info> referee_info;
 
-        bool auto_aim_status = false;
+        UserLib::SeqLock<VisionInput> &vision(int gimbal_id) {
+            return gimbal_id == 1 ? vision_gimbal1 : vision_gimbal2;
+        }
 
-        Types::ROBOT_MODE mode = Types::ROBOT_MODE::ROBOT_NO_FORCE;
-        Types::ROBOT_MODE last_mode = Types::ROBOT_MODE::ROBOT_NO_FORCE;
+        UserLib::SeqLock<GimbalState> &gimbal_state(int gimbal_id) {
+            return gimbal_id == 1 ? gimbalT_1_state : gimbalT_2_state;
+        }
 
-        Types::ReceivePacket_Super_Cap super_cap_info;
-        Types::Referee_info referee_info;
+        Inputs inputs() const {
+            Inputs in{ rc.load(),
+                       { vision_gimbal1.load(), vision_gimbal2.load() },
+                       mode.load(std::memory_order_acquire),
+                       false,
+                       input_now_ns() };
+            if (ISDEF(CONFIG_SENTRY)) {
+                in.game_started =
+                    (referee_info.load().game_status_data.game_progress & 0x0f) == 4;
+            }
+            return in;
+        }
 
         void set_mode(Types::ROBOT_MODE set_mode) {
-            this->last_mode = this->mode;
+            this->last_mode = this->mode.load();
             this->mode = set_mode;
         }
 
         bool mode_changed() {
             if (this->last_mode != this->mode) {
-                this->last_mode = this->mode;
+                this->last_mode = this->mode.load();
                 return true;
             }
             return false;
@@ -141,6 +278,13 @@ namespace Robot
         bool fire;
 
         Types::ROBOT_MODE mode = Types::ROBOT_MODE::ROBOT_NO_FORCE;
+
+        // 可选的时间戳字段，旧版视觉发的短包收到后这里全为 0
+        // seq 从 1 开始，sent_ns 为发送方的 CLOCK_MONOTONIC (同机时与本机同一时钟)
+        uint32_t seq = 0;
+        uint64_t sent_ns = 0;
+        // 发送方收到的最新一帧 SendAutoAimInfo::sent_ns，本机时钟，用来算往返延迟
+        uint64_t echo_ns = 0;
     } __attribute__((packed));
 
     struct SendAutoAimInfo
@@ -149,6 +293,13 @@ namespace Robot
         float yaw;
         float pitch;
         bool red;
+
+        // 追加在旧字段之后，只读前 10 字节的旧版视觉不受影响
+        uint32_t seq = 0;
+        uint64_t sent_ns = 0;
+        // 最近一条被采用的 Auto_aim_control 的 seq / sent_ns 原样返回
+        uint32_t echo_seq = 0;
+        uint64_t echo_ns = 0;
     } __attribute__((packed));
 
     struct SendVisionControl
@@ -1,4 +1,5 @@
 #pragma once
+#include <csignal>
 #include <memory>
 #include <thread>
 
@@ -6,6 +7,7 @@
 #include "device/super_cap.hpp"
 #include "gimbal/gimbal_sentry.hpp"
 #include "gimbal/gimbal_temp.hpp"
+#include "periodic_executor.hpp"
 #include "rc_controller.hpp"
 #include "referee.hpp"
 #include "robot.hpp"
@@ -24,11 +26,18 @@ namespace Robot
         Robot_ctrl();
         ~Robot_ctrl();
 
-        void load_hardware();
+        // replay: offline CAN interfaces and no serial ports, the loops run but never wait for
+        // hardware and every frame they send is refused
+        void load_hardware(bool replay = false);
         void start_init();
         void init_join();
         void start();
         void join();
+        [[noreturn]] void io_diagnostics_task();
+        // Config::CONTROL_PIPELINE: CAN RX barrier -> controllers -> motor TX in one tick
+        void pipeline_tick();
+        // SIGINT/SIGTERM: stops the control loops, dumps their timing and exits
+        [[noreturn]] void exit_task(sigset_t set);
 
        public:
         std::vector<std::jthread> threads;
@@ -42,6 +51,32 @@ namespace Robot
         IFDEF(CONFIG_SENTRY, Gimbal::GimbalT gimbal_sentry);
 
         Device::Super_Cap super_cap;
+
+        struct PipelineStats
+        {
+            // sense stage: waiting for fresh feedback from every online motor, ns
+            UserLib::Histogram rx_wait;
+            // oldest feedback frame the controllers used -> command frames sent, ns
+            UserLib::Histogram e2e;
+            // ticks that computed without fresh feedback from every motor
+            std::atomic<uint64_t> rx_timeouts{ 0 };
+        };
+        PipelineStats pipeline;
+
+       private:
+        void start_loops();
+        void start_pipeline();
+
+        bool replay_mode = false;
+        // { every n ticks, controller } in the order the pipeline runs them
+        std::vector<std::pair<uint32_t, std::function<void()>>> pipeline_stages;
+        uint64_t pipeline_ticks = 0;
+        Device::DeviceBase::time_point pipeline_last_tx;
+        uint64_t pipeline_last_timeouts = 0;
+
+       public:
+        // 所有周期控制任务，放在最后: 析构时先停下线程，再析构它们调用的模块
+        UserLib::PeriodicExecutor executor;
     };
 
 }  // namespace Robot
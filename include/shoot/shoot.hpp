@@ -15,7 +15,8 @@ namespace Shoot
         Shoot(const ShootConfig& config);
         void init(const std::shared_ptr<Robot::Robot_set>& robot);
         ~Shoot() = default;
-        [[noreturn]] void task();
+        // one control period, run by the executor every SHOOT_CONTROL_TIME ms
+        void tick();
         bool isJam();
 
        public:
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+namespace UserLib
+{
+    /**
+     * 无锁的对数-线性直方图 (HDR 风格)，用于记录延迟等非负整数样本(一般以ns为单位)
+     * 每个2的幂区间被划分为 SUB 个线性子桶，相对误差不超过 1/SUB
+     * record 可以在任意线程中调用，不会分配内存也不会阻塞
+     */
+    class Histogram
+    {
+       public:
+        static constexpr int SUB_BITS = 4;
+        static constexpr int SUB = 1 << SUB_BITS;
+        static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+        void record(uint64_t value) {
+            buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(value, std::memory_order_relaxed);
+            uint64_t prev = max_value.load(std::memory_order_relaxed);
+            while (prev < value &&
+                   !max_value.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+            }
+        }
+
+        uint64_t count() const {
+            return total.load(std::memory_order_relaxed);
+        }
+
+        uint64_t max() const {
+            return max_value.load(std::memory_order_relaxed);
+        }
+
+        double mean() const {
+            uint64_t n = count();
+            return n == 0 ? 0. : static_cast<double>(sum.load(std::memory_order_relaxed)) / n;
+        }
+
+        // p in [0, 1], returns the lower bound of the bucket holding the p-quantile
+        uint64_t percentile(double p) const {
+            uint64_t n = count();
+            if (n == 0) {
+                return 0;
+            }
+            auto target = static_cast<uint64_t>(p * static_cast<double>(n));
+            if (target >= n) {
+                target = n - 1;
+            }
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; i++) {
+                seen += buckets[i].load(std::memory_order_relaxed);
+                if (seen > target) {
+                    return bucket_value(i);
+                }
+            }
+            return max();
+        }
+
+        void reset() {
+            for (auto &bucket : buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            total.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+            max_value.store(0, std::memory_order_relaxed);
+        }
+
+        static constexpr int bucket_of(uint64_t value) {
+            if (value < 2 * SUB) {
+                return static_cast<int>(value);
+            }
+            int magnitude = 63 - std::countl_zero(value);
+            int shift = magnitude - SUB_BITS;
+            return (shift + 1) * SUB + static_cast<int>(value >> shift) - SUB;
+        }
+
+        static constexpr uint64_t bucket_value(int idx) {
+            if (idx < 2 * SUB) {
+                return static_cast<uint64_t>(idx);
+            }
+            int shift = idx / SUB - 1;
+            return static_cast<uint64_t>(SUB + idx % SUB) << shift;
+        }
+
+       private:
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+        std::atomic<uint64_t> total{ 0 };
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max_value{ 0 };
+    };
+}  // namespace UserLib
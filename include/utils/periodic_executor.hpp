@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "histogram.hpp"
+
+namespace UserLib
+{
+    /**
+     * 周期任务执行器，每个任务一个线程，按绝对截止时间唤醒 (clock_nanosleep + TIMER_ABSTIME)
+     * 周期不再是 "执行时间 + sleep"，长时间运行也不会漂移
+     * 所有任务共用构造时的 epoch，第 k 次唤醒在 epoch + phase + k * period，phase 决定同周期内的先后
+     */
+    class PeriodicExecutor
+    {
+       public:
+        // CLOCK_MONOTONIC on Linux
+        using Clock = std::chrono::steady_clock;
+
+        // what to do when a tick ends after the next deadline
+        enum class Overrun
+        {
+            // drop the missed deadlines and stay on the epoch + phase grid
+            SKIP,
+            // run the missed ticks back to back, at most MAX_CATCH_UP in a row, then SKIP
+            CATCH_UP,
+            // restart the grid one period after the late tick ended
+            RESET,
+        };
+        static constexpr int MAX_CATCH_UP = 4;
+
+        struct Stats
+        {
+            std::atomic<uint64_t> ticks{ 0 };
+            // ticks that ended after the following deadline
+            std::atomic<uint64_t> overruns{ 0 };
+            // deadlines never run because of an overrun
+            std::atomic<uint64_t> skipped{ 0 };
+            // tick() ran longer than the task's budget
+            std::atomic<uint64_t> over_budget{ 0 };
+            // ns: tick start - deadline, between consecutive tick starts, tick() itself
+            Histogram wake_latency;
+            Histogram period;
+            Histogram exec;
+        };
+
+        struct Task
+        {
+            std::string name;
+            std::chrono::nanoseconds period;
+            std::chrono::nanoseconds phase;
+            Overrun policy;
+            std::function<void()> tick;
+            std::chrono::nanoseconds budget;
+            Stats stats;
+            std::jthread thread;
+
+            // counters at the previous diagnostics() call
+            uint64_t last_overruns = 0;
+            uint64_t last_skipped = 0;
+            uint64_t last_over_budget = 0;
+        };
+
+        using Publish = std::function<void(const std::string &key, double value)>;
+
+        PeriodicExecutor();
+        ~PeriodicExecutor();
+        PeriodicExecutor(const PeriodicExecutor &) = delete;
+        PeriodicExecutor &operator=(const PeriodicExecutor &) = delete;
+
+        // budget of the tasks added afterwards, as a share of their period
+        void set_budget(uint32_t percent);
+        // starts the task's thread (named after the task) right away, the first tick is the first
+        // grid point in the future; call from one thread only
+        const Task &add(
+            std::string name,
+            std::chrono::nanoseconds period,
+            std::chrono::nanoseconds phase,
+            std::function<void()> tick,
+            Overrun policy = Overrun::SKIP);
+        // every thread finishes its current tick and exits
+        void stop();
+        // only that task, its stats stay for diagnostics() and report()
+        void stop(const std::string &name);
+        // <task>.period/exec/wake _p50/_p99/_max_us since start,
+        // <task>.overruns/skipped/over_budget since the previous call
+        void diagnostics(const Publish &publish);
+        // every histogram of every task, for the exit dump
+        void report() const;
+
+        template<typename F>
+        void for_each(F &&fn) const {
+            for (const auto &task : tasks) {
+                fn(task);
+            }
+        }
+
+       private:
+        void run(Task &task, const std::stop_token &stop);
+
+        Clock::time_point epoch;
+        uint32_t budget_percent = 100;
+        std::deque<Task> tasks;
+    };
+}  // namespace UserLib
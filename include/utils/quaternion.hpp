@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+
+#include "types.hpp"
+
+namespace UserLib
+{
+    /**
+     * 单位四元数，欧拉角按 ZYX (yaw -> pitch -> roll) 的顺序转换，单位 rad
+     * 用来在两个姿态之间插值，避免直接插欧拉角时在 ±pi 处跳变
+     */
+    struct Quaternion
+    {
+        fp32 w = 1, x = 0, y = 0, z = 0;
+
+        static Quaternion from_euler(fp32 yaw, fp32 pitch, fp32 roll) {
+            fp32 cy = std::cos(yaw / 2), sy = std::sin(yaw / 2);
+            fp32 cp = std::cos(pitch / 2), sp = std::sin(pitch / 2);
+            fp32 cr = std::cos(roll / 2), sr = std::sin(roll / 2);
+            return { cr * cp * cy + sr * sp * sy,
+                     sr * cp * cy - cr * sp * sy,
+                     cr * sp * cy + sr * cp * sy,
+                     cr * cp * sy - sr * sp * cy };
+        }
+
+        fp32 yaw() const {
+            return std::atan2(2 * (w * z + x * y), 1 - 2 * (y * y + z * z));
+        }
+
+        fp32 pitch() const {
+            fp32 s = 2 * (w * y - z * x);
+            return std::abs(s) >= 1 ? std::copysign(M_PIf / 2, s) : std::asin(s);
+        }
+
+        fp32 roll() const {
+            return std::atan2(2 * (w * x + y * z), 1 - 2 * (x * x + y * y));
+        }
+
+        fp32 dot(const Quaternion &q) const {
+            return w * q.w + x * q.x + y * q.y + z * q.z;
+        }
+
+        // t in [0, 1], always along the shorter arc
+        static Quaternion slerp(const Quaternion &a, Quaternion b, fp32 t) {
+            fp32 cos_theta = a.dot(b);
+            if (cos_theta < 0) {
+                b = { -b.w, -b.x, -b.y, -b.z };
+                cos_theta = -cos_theta;
+            }
+            fp32 ka, kb;
+            if (cos_theta > 0.9995f) {
+                // nearly parallel: lerp, normalized below
+                ka = 1 - t;
+                kb = t;
+            } else {
+                fp32 theta = std::acos(cos_theta);
+                fp32 sin_theta = std::sin(theta);
+                ka = std::sin((1 - t) * theta) / sin_theta;
+                kb = std::sin(t * theta) / sin_theta;
+            }
+            Quaternion q{ ka * a.w + kb * b.w, ka * a.x + kb * b.x, ka * a.y + kb * b.y,
+                          ka * a.z + kb * b.z };
+            fp32 norm = std::sqrt(q.dot(q));
+            return { q.w / norm, q.x / norm, q.y / norm, q.z / norm };
+        }
+    };
+}  // namespace UserLib
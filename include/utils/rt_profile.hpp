@@ -0,0 +1,64 @@
+#pragma once
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace UserLib
+{
+    /**
+     * 实时运行配置: 按线程名设置 SCHED_FIFO 优先级和 CPU 亲和性，锁定内存并预先触碰线程栈
+     * 启动时用 --rt-profile <name> 或环境变量 GKD_RT_PROFILE 选择，不选时所有线程保持 SCHED_OTHER
+     */
+    class RtProfile
+    {
+       public:
+        struct Thread
+        {
+            std::string name;
+            // SCHED_FIFO priority 1..99, 0 keeps SCHED_OTHER
+            int priority = 0;
+            // bit i is cpu i, 0 leaves the affinity alone
+            uint64_t cpus = 0;
+        };
+
+        struct Profile
+        {
+            std::string name;
+            // mlockall(MCL_CURRENT | MCL_FUTURE) and no heap trimming, no page faults in the loops
+            bool lock_memory = false;
+            // bytes of stack every controlled thread touches before its first tick
+            size_t prefault_stack = 0;
+            std::vector<Thread> threads;
+        };
+
+        // call from main before any thread starts, false for an unknown name
+        bool select(const std::vector<Profile> &profiles, const std::string &name);
+        // names the thread and applies its entry of the selected profile, if any
+        void apply(const std::string &name, pthread_t thread);
+        // touches prefault_stack bytes below the caller's frame
+        void prefault_stack() const;
+        // what was applied to each thread, LOG_ERR for whatever the kernel refused
+        void report() const;
+
+       private:
+        struct Applied
+        {
+            Thread thread;
+            int sched_error = 0;
+            int affinity_error = 0;
+        };
+
+        mutable std::mutex lock;
+        bool active = false;
+        Profile selected;
+        int mlock_error = 0;
+        std::vector<Applied> applied;
+    };
+
+    inline RtProfile rt_profile;
+}  // namespace UserLib
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace UserLib
+{
+    /**
+     * 单写者多读者的 seqlock，数据存两份 (seqcount latch): 写者先把读者切到另一份再改这一份
+     * 读者不加锁也不会等写者写完，只有一次 load 和写入重叠时才重读一遍，1ms 的控制循环不会被阻塞
+     * 数据按 8 字节原子字存储，读写都没有 data race
+     */
+    template<typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+       public:
+        SeqLock() {
+            store(T{});
+        }
+        SeqLock(const SeqLock &) = delete;
+        SeqLock &operator=(const SeqLock &) = delete;
+
+        // a consistent copy of the last store(), from any thread
+        T load() const {
+            while (true) {
+                auto s = seq.load(std::memory_order_acquire);
+                Words words;
+                for (size_t i = 0; i < WORDS; i++) {
+                    words[i] = buffers[s & 1][i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq.load(std::memory_order_relaxed) == s) {
+                    T value;
+                    std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+                    return value;
+                }
+            }
+        }
+
+        // writer thread only
+        void store(const T &value) {
+            shadow = value;
+            Words words{};
+            std::memcpy(words.data(), &value, sizeof(T));
+            auto s = seq.load(std::memory_order_relaxed);
+            // readers move to buffers[1] while buffers[0] is written, then back
+            publish(s + 1);
+            write(buffers[0], words);
+            publish(s + 2);
+            write(buffers[1], words);
+        }
+
+        // writer thread only, for partial updates such as one referee command: fn(T &) edits the
+        // writer's own copy which is then published as a whole
+        template<typename F>
+        void update(F &&fn) {
+            T value = shadow;
+            fn(value);
+            store(value);
+        }
+
+       private:
+        static constexpr size_t WORDS = (sizeof(T) + 7) / 8;
+        using Words = std::array<uint64_t, WORDS>;
+        using Buffer = std::array<std::atomic<uint64_t>, WORDS>;
+
+        void publish(uint64_t s) {
+            seq.store(s, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        static void write(Buffer &buffer, const Words &words) {
+            for (size_t i = 0; i < WORDS; i++) {
+                buffer[i].store(words[i], std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<uint64_t> seq{ 0 };
+        Buffer buffers[2];
+        T shadow{};
+    };
+}  // namespace UserLib
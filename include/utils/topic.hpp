@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "utils.hpp"
+
+namespace UserLib
+{
+    /**
+     * 话题: 单写者的定长消息环，每个槽一个 seqlock，消息带序号和发布时间
+     * 槽按 8 字节原子字存储 (同 SeqLock)，读者不加锁地拷出一份，校验槽没有被改写后才交给回调
+     * 话题记录发布次数和最新时间，可以判断是否过期，TopicBus::diagnostics 由此给出频率
+     * 每个话题只能有一个写者: 多个线程会发布时 (例如一个接口的两条接收路径)，
+     * 由生产者把分发串行化; publish 检查写者重叠并计数，diagnostics 和 report 会报出来
+     */
+    class TopicBase
+    {
+       public:
+        using Clock = std::chrono::steady_clock;
+
+        TopicBase(std::string name, std::chrono::nanoseconds max_age)
+            : name_(std::move(name)),
+              max_age(max_age) {
+        }
+        virtual ~TopicBase() = default;
+        TopicBase(const TopicBase &) = delete;
+        TopicBase &operator=(const TopicBase &) = delete;
+
+        const std::string &name() const {
+            return name_;
+        }
+
+        // messages published so far, the newest one has index published() - 1
+        uint64_t published() const {
+            return written.load(std::memory_order_acquire);
+        }
+
+        Clock::time_point last_stamp() const {
+            return Clock::time_point(Clock::duration(stamp.load(std::memory_order_relaxed)));
+        }
+
+        // since the newest message, nanoseconds::max() before the first one
+        std::chrono::nanoseconds age() const {
+            if (published() == 0) {
+                return std::chrono::nanoseconds::max();
+            }
+            return Clock::now() - last_stamp();
+        }
+
+        // nothing published yet, or the newest message is older than max_age (0: never stale)
+        bool stale() const {
+            return published() == 0 || (max_age.count() > 0 && age() > max_age);
+        }
+
+        // reads discarded because the writer rewrote the slot meanwhile
+        uint64_t torn() const {
+            return torn_reads.load(std::memory_order_relaxed);
+        }
+
+        // publishes that started while another one was still running, always 0 with one writer
+        uint64_t overlapped() const {
+            return overlapped_writes.load(std::memory_order_relaxed);
+        }
+
+       protected:
+        std::string name_;
+        std::chrono::nanoseconds max_age;
+        std::atomic<uint64_t> written{ 0 };
+        std::atomic<Clock::rep> stamp{ 0 };
+        mutable std::atomic<uint64_t> torn_reads{ 0 };
+        std::atomic<bool> writing{ false };
+        std::atomic<uint64_t> overlapped_writes{ 0 };
+
+       private:
+        friend class TopicBus;
+        // state at the previous TopicBus::diagnostics() call
+        uint64_t last_published = 0;
+        uint64_t last_torn = 0;
+        uint64_t last_overlapped = 0;
+        Clock::time_point last_diagnostics = Clock::now();
+    };
+
+    template<typename T, size_t N = 16>
+    class Topic : public TopicBase
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(N >= 2);
+
+       public:
+        static constexpr size_t HISTORY = N;
+
+        struct Message
+        {
+            uint64_t index;
+            Clock::time_point stamp;
+            T data;
+        };
+
+        using TopicBase::TopicBase;
+
+        // writer thread only
+        void publish(const T &data, Clock::time_point stamp_ = Clock::now()) {
+            if (writing.exchange(true, std::memory_order_acquire)) {
+                overlapped_writes.fetch_add(1, std::memory_order_relaxed);
+            }
+            uint64_t index = written.load(std::memory_order_relaxed);
+            auto &slot = slots[index % N];
+            Message message{ index, stamp_, data };
+            Words words{};
+            std::memcpy(words.data(), &message, sizeof(Message));
+            uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+            slot.seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORDS; i++) {
+                slot.words[i].store(words[i], std::memory_order_relaxed);
+            }
+            slot.seq.store(seq + 2, std::memory_order_release);
+            stamp.store(stamp_.time_since_epoch().count(), std::memory_order_relaxed);
+            written.store(index + 1, std::memory_order_release);
+            writing.store(false, std::memory_order_release);
+        }
+
+        /**
+         * fn(const Message &) 拿到的是校验过的副本，返回 false 表示槽正在被改写或已经是别的序号，
+         * 这时 fn 不会被调用; fn 不能保存引用
+         */
+        template<typename F>
+        bool read(uint64_t index, F &&fn) const {
+            const auto &slot = slots[index % N];
+            uint32_t before = slot.seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                return false;
+            }
+            Words words;
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != before) {
+                torn_reads.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            // the index is only trusted from the validated copy
+            Message message;
+            std::memcpy(static_cast<void *>(&message), words.data(), sizeof(Message));
+            if (message.index != index) {
+                return false;
+            }
+            fn(message);
+            return true;
+        }
+
+        // newest message, false before the first publish
+        template<typename F>
+        bool latest(F &&fn) const {
+            while (true) {
+                uint64_t end = published();
+                if (end == 0) {
+                    return false;
+                }
+                // only fails when the writer went round the whole ring during the copy
+                if (read(end - 1, fn)) {
+                    return true;
+                }
+            }
+        }
+
+        std::optional<Message> latest() const {
+            std::optional<Message> out;
+            if (!latest([&](const Message &message) { out = message; })) {
+                return std::nullopt;
+            }
+            return out;
+        }
+
+        // every message from index on that is still in the ring, oldest first; returns the index
+        // to continue from next time, messages already overwritten are skipped
+        template<typename F>
+        uint64_t since(uint64_t index, F &&fn) const {
+            uint64_t end = published();
+            for (uint64_t i = std::max(index, end > N ? end - N : 0); i < end; i++) {
+                read(i, fn);
+            }
+            return end;
+        }
+
+       private:
+        static constexpr size_t WORDS = (sizeof(Message) + 7) / 8;
+        using Words = std::array<uint64_t, WORDS>;
+
+        // seqlock: seq is odd while the writer rewrites the slot
+        struct Slot
+        {
+            std::atomic<uint32_t> seq{ 0 };
+            std::array<std::atomic<uint64_t>, WORDS> words{};
+        };
+
+        std::array<Slot, N> slots;
+    };
+
+    /**
+     * 按名字登记的话题，生产者和消费者在初始化时各自取一次引用，之后的发布和读取不经过总线
+     */
+    class TopicBus
+    {
+       public:
+        using Publish = std::function<void(const std::string &key, double value)>;
+
+        // created on first use, max_age only counts then; the same name with another message
+        // type or history length throws
+        template<typename T, size_t N = 16>
+        Topic<T, N> &topic(const std::string &name, std::chrono::nanoseconds max_age = {}) {
+            std::unique_lock guard(lock);
+            auto &slot = topics[name];
+            if (slot == nullptr) {
+                slot = std::make_unique<Topic<T, N>>(name, max_age);
+            }
+            auto topic = dynamic_cast<Topic<T, N> *>(slot.get());
+            if (topic == nullptr) {
+                LOG_ERR("topic error: %s registered with another message type\n", name.c_str());
+                throw std::runtime_error("topic error: " + name + " registered with another type");
+            }
+            return *topic;
+        }
+
+        // <topic>.hz, <topic>.torn and <topic>.overlap since the previous call,
+        // <topic>.age_ms and <topic>.stale now
+        void diagnostics(const Publish &publish);
+        // every topic's message count, age and torn reads, for the exit dump
+        void report() const;
+
+       private:
+        mutable std::mutex lock;
+        std::map<std::string, std::unique_ptr<TopicBase>> topics;
+    };
+
+    inline TopicBus topic_bus;
+}  // namespace UserLib
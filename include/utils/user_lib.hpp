@@ -8,6 +8,8 @@ namespace UserLib
 {
     fp32 rad_format(fp32 ang);
     void sleep_ms(uint32_t dur);
+    // CLOCK_MONOTONIC in ns, the clock the auto-aim packets are stamped with
+    uint64_t steady_ns();
 
     template<typename T>
     void unpack(T &t, void *ptr) {
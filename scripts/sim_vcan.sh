@@ -0,0 +1,21 @@
+#!/bin/bash
+# Bring up the virtual CAN buses used by `make sim` (config_infantry.hpp under CONFIG_SIM).
+#   sudo scripts/sim_vcan.sh [--fd]
+# --fd raises the MTU to 72 so CAN FD frames (Config::CanFdList) can be exchanged as well.
+
+set -e
+
+MTU=16
+if [ "$1" == "--fd" ]; then
+    MTU=72
+fi
+
+modprobe vcan
+for dev in vcan0 vcan1; do
+    if ! ip link show "$dev" > /dev/null 2>&1; then
+        ip link add dev "$dev" type vcan
+    fi
+    ip link set "$dev" mtu "$MTU"
+    ip link set up "$dev"
+    echo "$dev up (mtu $MTU)"
+done
@@ -22,13 +22,9 @@ namespace Chassis
         power_manager.init(robot);
         power_manager.setMode(1);
 
-        chassis_angle_pid = Pid::PidRad(
-                                config.chassis_follow_gimbal_pid_config,
-                                MUXDEF(
-                                    CONFIG_SENTRY,
-                                    robot_set->gimbal_sentry_yaw_reletive,
-                                    robot_set->gimbalT_1_yaw_reletive)) >>
-                            Pid::Invert(config.follow_dir);
+        chassis_angle_pid =
+            Pid::PidRad(config.chassis_follow_gimbal_pid_config, gimbal_yaw_relative) >>
+            Pid::Invert(config.follow_dir);
 
         for (auto &motor : motors) {
             motor.setCtrl(Pid::PidPosition(
@@ -44,77 +40,79 @@ namespace Chassis
 
     }
 
-    [[noreturn]] void Chassis::task() {
-        std::jthread power_daemon(&Power::Manager::powerDaemon, &power_manager);
-        while (true) {
-            decomposition_speed();
-            LOG_INFO("chassis.wheel_speed: %f, %f, %f, %f\n", wheel_speed[0], wheel_speed[1], wheel_speed[2], wheel_speed[3]);
-            if (robot_set->mode == Types::ROBOT_MODE::ROBOT_NO_FORCE) {
-                for (auto &motor : motors) {
-                    motor.set(0.f);
-                }
-            } else {
-                fp32 max_speed = 0.f;
+    void Chassis::tick() {
+        auto in = robot_set->inputs();
+        gimbal_yaw_relative =
+            MUXDEF(CONFIG_SENTRY, robot_set->gimbal_sentry_state, robot_set->gimbalT_1_state)
+                .load()
+                .yaw_relative;
+        decomposition_speed(in);
+        LOG_INFO("chassis.wheel_speed: %f, %f, %f, %f\n", wheel_speed[0], wheel_speed[1], wheel_speed[2], wheel_speed[3]);
+        if (in.mode() == Types::ROBOT_MODE::ROBOT_NO_FORCE) {
+            for (auto &motor : motors) {
+                motor.set(0.f);
+            }
+        } else {
+            fp32 max_speed = 0.f;
+            for (int i = 0; i < 4; i++) {
+                max_speed = std::max(max_speed, fabsf(wheel_speed[i]));
+            }
+            //TODO 增加加速度限制
+            if (max_speed > max_wheel_speed) {
+                fp32 speed_rate = max_wheel_speed / max_speed;
                 for (int i = 0; i < 4; i++) {
-                    max_speed = std::max(max_speed, fabsf(wheel_speed[i]));
-                }
-                //TODO 增加加速度限制
-                if (max_speed > max_wheel_speed) {
-                    fp32 speed_rate = max_wheel_speed / max_speed;
-                    for (int i = 0; i < 4; i++) {
-                        wheel_speed[i] *= speed_rate;
-                    }
+                    wheel_speed[i] *= speed_rate;
                 }
+            }
 
-                for (int i = 0; i < 4; i++) {
-                    wheels_pid[i].set(wheel_speed[i]);
-                }
+            for (int i = 0; i < 4; i++) {
+                wheels_pid[i].set(wheel_speed[i]);
+            }
 
-                robot_set->spin_state = robot_set->wz_set < 0.1 ? false : true;
-                // LOG_INFO("spin?: %d\n", robot_set->spin_state);
+            robot_set->spin_state = in.wz_set() < 0.1 ? false : true;
+            // LOG_INFO("spin?: %d\n", robot_set->spin_state);
 
-                // Power Limit
-                for (int i = 0; i < 4; ++i) {
-                    objs[i].curAv = motors[i].motor_measure_.speed_rpm * M_PIf / 30;
-                    objs[i].pidOutput = wheels_pid[i].out;
-                    objs[i].setAv = wheel_speed[i];
-                    objs[i].pidMaxOutput = 14000;
-                }
-                static Power::PowerObj *pObjs[4] = { &objs[0], &objs[1], &objs[2], &objs[3] };
-                std::array<float, 4> cmd_power = power_manager.getControlledOutput(pObjs);
+            // Power Limit
+            for (int i = 0; i < 4; ++i) {
+                objs[i].curAv = motors[i].motor_measure_.speed_rpm * M_PIf / 30;
+                objs[i].pidOutput = wheels_pid[i].out;
+                objs[i].setAv = wheel_speed[i];
+                objs[i].pidMaxOutput = 14000;
+            }
+            static Power::PowerObj *pObjs[4] = { &objs[0], &objs[1], &objs[2], &objs[3] };
+            std::array<float, 4> cmd_power = power_manager.getControlledOutput(pObjs);
 
-                //logger
-                for (int i = 0; i < 4; ++i) {
-                   logger.push_value("chassis." + std::to_string(i), cmd_power[i]);
-                //    logger.push_console_message("<h1>111</h1>");
-                }
+            //logger
+            for (int i = 0; i < 4; ++i) {
+               logger.push_value("chassis." + std::to_string(i), cmd_power[i]);
+            //    logger.push_console_message("<h1>111</h1>");
+            }
 
-                for (int i = 0; i < 4; ++i) {
-                    if(motors[i].offline()) {
-                        LOG_ERR("chassis_%d offline\n", i + 1);
-                    }
-                    motors[i].give_current = cmd_power[i];
+            for (int i = 0; i < 4; ++i) {
+                if(motors[i].offline()) {
+                    LOG_ERR("chassis_%d offline\n", i + 1);
                 }
+                motors[i].give_current = cmd_power[i];
             }
-            UserLib::sleep_ms(config.ControlTime);
         }
     }
 
-    void Chassis::decomposition_speed() {
-        if (robot_set->mode != Types::ROBOT_MODE::ROBOT_NO_FORCE) {
+    void Chassis::power_tick() {
+        power_manager.tick();
+    }
+
+    void Chassis::decomposition_speed(const Robot::Inputs &in) {
+        if (in.mode() != Types::ROBOT_MODE::ROBOT_NO_FORCE) {
             fp32 sin_yaw, cos_yaw;
-            MUXDEF(
-                CONFIG_SENTRY,
-                sincosf(robot_set->gimbal_sentry_yaw_reletive, &sin_yaw, &cos_yaw),
-                sincosf(robot_set->gimbalT_1_yaw_reletive, &sin_yaw, &cos_yaw));
-            vx_set = cos_yaw * robot_set->vx_set + sin_yaw * robot_set->vy_set;
-            vy_set = -sin_yaw * robot_set->vx_set + cos_yaw * robot_set->vy_set;
-
-            if (robot_set->wz_set == 0.f) {
+            sincosf(gimbal_yaw_relative, &sin_yaw, &cos_yaw);
+            vx_set = cos_yaw * in.rc.vx_set + sin_yaw * in.rc.vy_set;
+            vy_set = -sin_yaw * in.rc.vx_set + cos_yaw * in.rc.vy_set;
+
+            if (in.wz_set() == 0.f) {
                 chassis_angle_pid.set(0.f);
                 wz_set = chassis_angle_pid.out;
             } else {
-                wz_set = robot_set->wz_set;
+                wz_set = in.wz_set();
             }
         }
 
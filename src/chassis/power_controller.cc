@@ -226,142 +226,139 @@ std::array<float, 4> Manager::getControlledOutput(PowerObj *objs[4]) {
     return newTorqueCurrent; // 直接返回 std::array
 }
 
-   [[noreturn]] void Manager::powerDaemon () {
+    void Manager::tick() {
         static Math::Matrixf<2, 1> samples;
         static Math::Matrixf<2, 1> params;
         static float effectivePower = 0;
         //std::ofstream outputFile("log/log.txt");
 
-        isInitialized = true;
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-        lastUpdateTick = clock();
-
-        while (true) {
-            setMode(1);
-            float torqueConst = 0.3 * ((float)187 / 3591);
-            float k0 =
-                torqueConst * 20 / 16384;  // torque current rate of the motor, defined as Nm/Output
-            // NOTE: DEBUG SET LEVEL TO 1
-
-            size_t now = clock();
-
-            // update rls state and check whether cap energy is out even when cap
-            // disconnect to utilize credible data from referee system for the rls model
-            // estimate the cap energy if cap disconnect
-            // estimated cap energy = cap energy feedback when cap is connected
-            isCapEnergyOut = false;
-            estimatedCapEnergy = robot_set->super_cap_info.capEnergy / 255.0f * 2100.0f;
-
-            // Set the power buff and buff set based on the current state
-            // Take cap message as priority
-            // If disconnect from cap or disable the cap, then take the referee system's
-            // power buffer as feedback If referee system is disconnected, then we need
-            // to disable the energy loop and treat power loop conservatively When both
-            // cap and referee are disconnected, we disable the energy loop and
-            // therefore no need to update the powerBuff and buffSet
-            //
-            // Set the energy feedback based on the current error status
-            powerBuff = sqrtf(robot_set->super_cap_info.capEnergy);
-
-            // Set the energy target based on the current error status
-            fullBuffSet = capFullBuffSet;  // 230
-            baseBuffSet = capBaseBuffSet;  // 30
-
-            // Update the referee maximum power limit and user configured power limit
-            // If disconnected, then restore the last robot level and find corresponding
-            // chassis power limit
-            refereeMaxPower = fmax(
-                robot_set->super_cap_info.chassisPowerlimit,
-                CAP_OFFLINE_ENERGY_RUNOUT_POWER_THRESHOLD);
-
-            powerUpperLimit = refereeMaxPower + MAX_CAP_POWER_OUT;
-            // FIXME: referee leve to set lower limit
-            powerLowerLimit = 50;
-
-            MIN_MAXPOWER_CONFIGURED = 50 * 0.8;
-
-            // energy loop
-            // if cap and referee both gg, set the max power to latest power limit *
-            // 0.85 and disable energy loop if referee gg, set the max power to latest
-            // power limit * 0.95, enable energy loop when cap energy out
-            powerPD_base.set(sqrtf(baseBuffSet));
-            powerPD_full.set(sqrtf(fullBuffSet));
-            baseMaxPower = fmax(refereeMaxPower - powerPD_base.out, MIN_MAXPOWER_CONFIGURED);
-            fullMaxPower = fmax(refereeMaxPower - powerPD_full.out, MIN_MAXPOWER_CONFIGURED);
-
-            // Estimate the power based on the current model
-            effectivePower = 0;
-            samples[0][0] = 0;
-            samples[1][0] = 0;
-            for (int i = 0; i < 4; i++) {
-                //LOG_INFO("%d", motors[i].motor_measure_.given_current);
-
-                effectivePower += motors[i].motor_measure_.given_current * k0 *
-                                  rpm2av(motors[i].motor_measure_.speed_rpm);
-                samples[0][0] += fabsf(rpm2av(motors[i].motor_measure_.speed_rpm));
-                samples[1][0] += motors[i].motor_measure_.given_current * k0 *
-                                 motors[i].motor_measure_.given_current * k0;
-            }
-            estimatedPower = k1 * samples[0][0] + k2 * samples[1][0] + effectivePower + k3;
-
-            // Get the measured power from cap
-            // If cap is disconnected, get measured power from referee feedback if cap
-            // energy is out Otherwise, set it to estimated power
-            measuredPower = robot_set->super_cap_info.chassisPower;
-            // NOTE: log k1 k2 k3
-            // LOG_INFO(
-            //     "%f %f %f %f %f %f\n", measuredPower, effectivePower, estimatedPower, k1, k2,
-            //     k3);
-
-            // NOTE: log PIDs
-            // LOG_INFO(
-            //    "%f, %f, %f, %f, %f %d\n",
-            //    sqrtf(baseBuffSet),
-            //    powerBuff,
-            //    refereeMaxPower,
-            //    powerPD_base.out,
-            //    baseMaxPower,
-            //    robot_set->super_cap_info.capEnergy);
-
-            // NOTE: log super_cat_info
-            // LOG_INFO(
-            //    "%d %f %d\n",
-            //    robot_set->super_cap_info.capEnergy,
-            //    robot_set->super_cap_info.chassisPower,
-            //    robot_set->super_cap_info.chassisPowerlimit);
-
-            // NOTE: for dumping log and draw purpose
-            // printf("%f, %f\n", baseMaxPower, fullMaxPower);
-            // outputFile << refereeMaxPower << ", " << baseMaxPower << "\n" << std::flush;
-            //outputFile << baseMaxPower << ", " << fullMaxPower << "\n" << std::flush;
-
-            // update power status
-            powerStatus.userConfiguredMaxPower = userConfiguredMaxPower;
-            powerStatus.effectivePower = effectivePower;
-            powerStatus.powerLoss = measuredPower - effectivePower;
-            powerStatus.efficiency = std::clamp(effectivePower / measuredPower, 0.0f, 1.0f);
-            powerStatus.estimatedCapEnergy =
-                static_cast<uint8_t>(estimatedCapEnergy / 2100.0f * 255.0f);
-            powerStatus.error = static_cast<Manager::ErrorFlags>(error);
-
-            // Update the RLS parameterMAX_CAP_POWER_OUTs AND
-            // Add dead zone AND
-            // The Referee System could not detect negative power, leading to failure of
-            // real measurement. So use estimated power to evaluate this situtation
-            if (fabs(measuredPower) > 5.0f) {
-                params = rls.update(samples, measuredPower - effectivePower - k3);
-                k1 = fmax(params[0][0],
-                          1e-5f);  // In case the k1 diverge to negative number
-                k2 = fmax(params[1][0],
-                          1e-5f);  // In case the k2 diverge to negative number
-            }
+        // the first period only starts the daemon, like the 1ms wait of the old loop
+        if (!isInitialized) {
+            isInitialized = true;
+            lastUpdateTick = clock();
+            return;
+        }
 
-            lastUpdateTick = now;
+        setMode(1);
+        float torqueConst = 0.3 * ((float)187 / 3591);
+        float k0 =
+            torqueConst * 20 / 16384;  // torque current rate of the motor, defined as Nm/Output
+        // NOTE: DEBUG SET LEVEL TO 1
+
+        size_t now = clock();
+
+        // update rls state and check whether cap energy is out even when cap
+        // disconnect to utilize credible data from referee system for the rls model
+        // estimate the cap energy if cap disconnect
+        // estimated cap energy = cap energy feedback when cap is connected
+        auto cap = robot_set->super_cap_info.load();
+        isCapEnergyOut = false;
+        estimatedCapEnergy = cap.capEnergy / 255.0f * 2100.0f;
+
+        // Set the power buff and buff set based on the current state
+        // Take cap message as priority
+        // If disconnect from cap or disable the cap, then take the referee system's
+        // power buffer as feedback If referee system is disconnected, then we need
+        // to disable the energy loop and treat power loop conservatively When both
+        // cap and referee are disconnected, we disable the energy loop and
+        // therefore no need to update the powerBuff and buffSet
+        //
+        // Set the energy feedback based on the current error status
+        powerBuff = sqrtf(cap.capEnergy);
+
+        // Set the energy target based on the current error status
+        fullBuffSet = capFullBuffSet;  // 230
+        baseBuffSet = capBaseBuffSet;  // 30
+
+        // Update the referee maximum power limit and user configured power limit
+        // If disconnected, then restore the last robot level and find corresponding
+        // chassis power limit
+        refereeMaxPower =
+            fmax(cap.chassisPowerlimit, CAP_OFFLINE_ENERGY_RUNOUT_POWER_THRESHOLD);
+
+        powerUpperLimit = refereeMaxPower + MAX_CAP_POWER_OUT;
+        // FIXME: referee leve to set lower limit
+        powerLowerLimit = 50;
+
+        MIN_MAXPOWER_CONFIGURED = 50 * 0.8;
+
+        // energy loop
+        // if cap and referee both gg, set the max power to latest power limit *
+        // 0.85 and disable energy loop if referee gg, set the max power to latest
+        // power limit * 0.95, enable energy loop when cap energy out
+        powerPD_base.set(sqrtf(baseBuffSet));
+        powerPD_full.set(sqrtf(fullBuffSet));
+        baseMaxPower = fmax(refereeMaxPower - powerPD_base.out, MIN_MAXPOWER_CONFIGURED);
+        fullMaxPower = fmax(refereeMaxPower - powerPD_full.out, MIN_MAXPOWER_CONFIGURED);
+
+        // Estimate the power based on the current model
+        effectivePower = 0;
+        samples[0][0] = 0;
+        samples[1][0] = 0;
+        for (int i = 0; i < 4; i++) {
+            //LOG_INFO("%d", motors[i].motor_measure_.given_current);
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            effectivePower += motors[i].motor_measure_.given_current * k0 *
+                              rpm2av(motors[i].motor_measure_.speed_rpm);
+            samples[0][0] += fabsf(rpm2av(motors[i].motor_measure_.speed_rpm));
+            samples[1][0] += motors[i].motor_measure_.given_current * k0 *
+                             motors[i].motor_measure_.given_current * k0;
+        }
+        estimatedPower = k1 * samples[0][0] + k2 * samples[1][0] + effectivePower + k3;
+
+        // Get the measured power from cap
+        // If cap is disconnected, get measured power from referee feedback if cap
+        // energy is out Otherwise, set it to estimated power
+        measuredPower = cap.chassisPower;
+        // NOTE: log k1 k2 k3
+        // LOG_INFO(
+        //     "%f %f %f %f %f %f\n", measuredPower, effectivePower, estimatedPower, k1, k2,
+        //     k3);
+
+        // NOTE: log PIDs
+        // LOG_INFO(
+        //    "%f, %f, %f, %f, %f %d\n",
+        //    sqrtf(baseBuffSet),
+        //    powerBuff,
+        //    refereeMaxPower,
+        //    powerPD_base.out,
+        //    baseMaxPower,
+        //    robot_set->super_cap_info.capEnergy);
+
+        // NOTE: log super_cat_info
+        // LOG_INFO(
+        //    "%d %f %d\n",
+        //    robot_set->super_cap_info.capEnergy,
+        //    robot_set->super_cap_info.chassisPower,
+        //    robot_set->super_cap_info.chassisPowerlimit);
+
+        // NOTE: for dumping log and draw purpose
+        // printf("%f, %f\n", baseMaxPower, fullMaxPower);
+        // outputFile << refereeMaxPower << ", " << baseMaxPower << "\n" << std::flush;
+        //outputFile << baseMaxPower << ", " << fullMaxPower << "\n" << std::flush;
+
+        // update power status
+        powerStatus.userConfiguredMaxPower = userConfiguredMaxPower;
+        powerStatus.effectivePower = effectivePower;
+        powerStatus.powerLoss = measuredPower - effectivePower;
+        powerStatus.efficiency = std::clamp(effectivePower / measuredPower, 0.0f, 1.0f);
+        powerStatus.estimatedCapEnergy =
+            static_cast<uint8_t>(estimatedCapEnergy / 2100.0f * 255.0f);
+        powerStatus.error = static_cast<Manager::ErrorFlags>(error);
+
+        // Update the RLS parameterMAX_CAP_POWER_OUTs AND
+        // Add dead zone AND
+        // The Referee System could not detect negative power, leading to failure of
+        // real measurement. So use estimated power to evaluate this situtation
+        if (fabs(measuredPower) > 5.0f) {
+            params = rls.update(samples, measuredPower - effectivePower - k3);
+            k1 = fmax(params[0][0],
+                      1e-5f);  // In case the k1 diverge to negative number
+            k2 = fmax(params[1][0],
+                      1e-5f);  // In case the k2 diverge to negative number
         }
+
+        lastUpdateTick = now;
     }
 
     /**
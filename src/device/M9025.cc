@@ -26,14 +26,20 @@ namespace Device
         temperate = frame.data[1];
     }
 
-    void M9025::unpack(const can_frame& frame) {
+    void M9025::unpack(const can_frame& frame, time_point stamp) {
         motor_measure.unpack(frame);
-        update_time();
+        update_time(stamp);
     }
 
     void M9025::enable() {
-        IO::io<CAN>[can_name] -> register_callback_key(
-                                  0x140 + id, [&](const can_frame& frame) { unpack(frame); });
+        can = IO::io<CAN>[can_name];
+        can->register_callback_key(
+            0x140 + id,
+            [](void* ctx, const can_frame& frame) {
+                auto motor = static_cast<M9025*>(ctx);
+                motor->unpack(frame, motor->can->rx_stamp());
+            },
+            this);
     }
 
 }  // namespace Device
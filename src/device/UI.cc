@@ -693,7 +693,7 @@ Graph_Data still_cross_line[7];
 char cap_text[30], auto_aim_text[10];
 int count = 0;  // 计数器
 
-void custom_ui_task(Device::Base *base_, uint8_t &robot_id_) {
+void custom_ui_task(Device::Base *base_, const std::function<uint8_t()> &robot_id_) {
     custom_UI_init(base_);
     sync_parameter();
     /*刷新超电部分*/
@@ -735,8 +735,8 @@ void custom_ui_task(Device::Base *base_, uint8_t &robot_id_) {
     osDelay(100);
 
     while (1) {
-        Robot_ID_Read = robot_id_;
-        Cilent_ID_Read = 0x100 + robot_id_;
+        Robot_ID_Read = robot_id_();
+        Cilent_ID_Read = 0x100 + Robot_ID_Read;
         // LOG_INFO("robot_id_ %x client id %x\n", Robot_ID_Read, Cilent_ID_Read);
         sync_parameter();
         update_dynamic_paramater(base_);
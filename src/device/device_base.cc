@@ -5,19 +5,31 @@ using namespace std::chrono;
 
 namespace Device
 {
-    DeviceBase::DeviceBase() : last_time(system_clock::now() - 10s), offline_time(Config::DEFAULT_OFFLINE_TIME) {
+    DeviceBase::DeviceBase() : last_time(steady_clock::now() - 10s), offline_time(Config::DEFAULT_OFFLINE_TIME) {
     }
 
     DeviceBase::DeviceBase(uint32_t offline_time_t)
-        : last_time(system_clock::now() - 10s),
+        : last_time(steady_clock::now() - 10s),
           offline_time(offline_time_t) {
     }
 
     bool DeviceBase::offline() const {
-        return duration_cast<milliseconds>(system_clock::now() - last_time).count() >= offline_time;
+        return duration_cast<milliseconds>(sample_age()).count() >= offline_time;
+    }
+
+    DeviceBase::time_point DeviceBase::sample_time() const {
+        return last_time.load(std::memory_order_relaxed);
+    }
+
+    nanoseconds DeviceBase::sample_age() const {
+        return steady_clock::now() - sample_time();
     }
 
     void DeviceBase::update_time() {
-        last_time = system_clock::now();
+        update_time(steady_clock::now());
+    }
+
+    void DeviceBase::update_time(time_point stamp) {
+        last_time.store(stamp, std::memory_order_relaxed);
     }
 }  // namespace Device
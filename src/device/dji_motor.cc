@@ -1,9 +1,13 @@
 #include "dji_motor.hpp"
 
 #include "io.hpp"
+#include "robot_type_config.hpp"
 
 #include <mutex>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
 
 namespace Hardware {
 
@@ -57,7 +61,7 @@ namespace Hardware {
         temperate = frame.data[6];
     }
 
-    void DJIMotor::unpack(const can_frame &frame) {
+    void DJIMotor::unpack(const can_frame &frame, time_point stamp) {
         motor_measure_.unpack(frame);
         data_.rotor_angle = ECD_8192_TO_RAD * static_cast<float>(motor_measure_.ecd);
         data_.rotor_angular_velocity = RPM_TO_RAD_S * static_cast<float>(motor_measure_.speed_rpm);
@@ -65,7 +69,8 @@ namespace Hardware {
 
         data_.output_angular_velocity = data_.rotor_angular_velocity * data_.reduction_ratio;
         data_.output_linear_velocity = data_.rotor_linear_velocity * data_.reduction_ratio;
-        update_time();
+        feedback->publish(motor_measure_, stamp);
+        update_time(stamp);
     }
 
     void DJIMotor::set(float x) {
@@ -74,13 +79,24 @@ namespace Hardware {
     }
 
     void DJIMotor::enable() {
+        if (motor_id_ != 0 && feedback == nullptr) {
+            char name[64];
+            snprintf(
+                name,
+                sizeof(name),
+                "motor.%s.0x%x",
+                can_info.can_name_.c_str(),
+                can_info.callback_flag);
+            // single writer: the CAN interface serializes RX and replay dispatch
+            feedback = &UserLib::topic_bus.topic<Message>(
+                name, std::chrono::milliseconds(Config::DEFAULT_OFFLINE_TIME));
+        }
         DJIMotorManager::register_motor(*this);
     }
 
     namespace DJIMotorManager {
 
         std::unordered_map<std::string, CanBlock> motors_map;
-        std::thread task_handle;
         std::mutex data_lock;
 
         bool can_conflict(const DJIMotor &motor1, const DJIMotor &motor2) {
@@ -99,7 +115,7 @@ namespace Hardware {
                 LOG_ERR("Motor error[%s]: can device is invalid\n", motor.motor_name_.c_str());
                 return;
             }
-            auto &[can_, motors_] = motors_map[motor.can_info.can_name_];
+            auto &[can_, motors_, packer_] = motors_map[motor.can_info.can_name_];
             can_ = can_interface;
             for (const auto &other_motor: motors_) {
                 if (can_conflict(*other_motor, motor)) {
@@ -109,52 +125,130 @@ namespace Hardware {
                 }
             }
             motor.motor_enabled_ = true;
+            motor.can_info.can_ = can_;
             motors_.push_back(&motor);
-            can_->register_callback_key(motor.can_info.callback_flag, [&](const can_frame &frame) {
-                motor.unpack(frame);
-            });
+            can_->register_callback_key(
+                motor.can_info.callback_flag,
+                [](void *ctx, const can_frame &frame) {
+                    auto motor = static_cast<DJIMotor *>(ctx);
+                    motor->unpack(frame, motor->can_info.can_->rx_stamp());
+                },
+                &motor);
+        }
+
+        // fills the 0x1FF/0x200/0x2FF command blocks, returns which of them carry a motor
+        static std::array<bool, 3> fill_blocks(
+            const std::vector<DJIMotor *> &motors, std::array<std::array<uint8_t, 8>, 3> &blocks) {
+            std::array<bool, 3> valid = { false, false, false };
+            blocks = {};
+            for (const auto motor: motors) {
+                auto idx = static_cast<int>(motor->can_info.can_id_);
+                valid[idx] = true;
+                blocks[idx][motor->can_info.data_bias] = static_cast<uint16_t>(motor->give_current) >> 8;
+                blocks[idx][motor->can_info.data_bias | 1] = motor->give_current & 0xff;
+            }
+            return valid;
+        }
+
+        void pack_classic(IO::Can_interface &can, const std::vector<DJIMotor *> &motors) {
+            static constexpr uint32_t ids[3] = {0x1ff, 0x200, 0x2ff};
+            std::array<std::array<uint8_t, 8>, 3> blocks;
+            auto valid = fill_blocks(motors, blocks);
+            // flush this tick's 0x1FF/0x200/0x2FF frames with a single syscall
+            can_frame out[3];
+            size_t num = 0;
+            for (int i = 0; i < 3; i++) {
+                if (valid[i]) {
+                    out[num] = {.can_id = ids[i], .len = 8};
+                    std::memcpy(out[num].data, blocks[i].data(), 8);
+                    num++;
+                }
+            }
+            if (num > 0) {
+                can.send_batch(out, num, IO::Can_interface::TxPriority::CONTROL);
+            }
+        }
+
+        Packer fd_bridge_packer(uint32_t can_id) {
+            return [can_id](IO::Can_interface &can, const std::vector<DJIMotor *> &motors) {
+                // enable_fd failed: the bridge can't be reached, drive the motors directly
+                if (!can.fd_enabled()) {
+                    pack_classic(can, motors);
+                    return;
+                }
+                std::array<std::array<uint8_t, 8>, 3> blocks;
+                fill_blocks(motors, blocks);
+                canfd_frame frame{};
+                frame.can_id = can_id;
+                frame.len = 24;
+                frame.flags = CANFD_BRS;
+                std::memcpy(frame.data, blocks.data(), sizeof(blocks));
+                can.send(frame, IO::Can_interface::TxPriority::CONTROL);
+            };
+        }
+
+        void set_packer(const std::string &can_name, Packer packer) {
+            std::unique_lock lock(data_lock);
+            motors_map[can_name].packer_ = std::move(packer);
         }
 
-        [[noreturn]] void task() {
-            static can_frame frame[3] = {{}, {}, {}};
-            static bool valid[3] = {false, false, false};
+        bool wait_feedback(
+            Device::DeviceBase::time_point since, std::chrono::nanoseconds timeout) {
+            // feedback arrives on the IO threads at 1kHz, poll instead of taxing every frame
+            constexpr auto POLL = std::chrono::microseconds(20);
+            auto deadline = std::chrono::steady_clock::now() + timeout;
             while (true) {
-                data_lock.lock();
-                auto now = std::chrono::steady_clock::now();
-                for (auto &[can_name, can_block]: motors_map) {
-                    if (can_block.can_ == nullptr) {
-                        can_block.can_ = IO::io<CAN>[can_name];
+                bool fresh = true;
+                {
+                    std::unique_lock lock(data_lock);
+                    for (auto &[can_name, can_block] : motors_map) {
+                        for (auto *motor : can_block.motors_) {
+                            fresh &= motor->offline() || motor->sample_time() > since;
+                        }
                     }
-                    if (can_block.can_ == nullptr) {
+                }
+                if (fresh) {
+                    return true;
+                }
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    return false;
+                }
+                std::this_thread::sleep_for(POLL);
+            }
+        }
+
+        Device::DeviceBase::time_point oldest_feedback() {
+            std::unique_lock lock(data_lock);
+            Device::DeviceBase::time_point oldest{};
+            for (auto &[can_name, can_block] : motors_map) {
+                for (auto *motor : can_block.motors_) {
+                    if (motor->offline()) {
                         continue;
                     }
-                    frame[0] = {.can_id = 0x1ff, .len = 8};
-                    frame[1] = {.can_id = 0x200, .len = 8};
-                    frame[2] = {.can_id = 0x2ff, .len = 8};
-                    valid[0] = valid[1] = valid[2] = false;
-                    for (const auto motor: can_block.motors_) {
-                        valid[static_cast<int>(motor->can_info.can_id_)] = true;
-                        auto data = frame[static_cast<int>(motor->can_info.can_id_)].data;
-                        data[motor->can_info.data_bias] = static_cast<uint16_t>(motor->give_current) >> 8;
-                        data[motor->can_info.data_bias | 1] = motor->give_current & 0xff;
-                    }
-                    if (valid[0]) {
-                        can_block.can_->send(frame[0]);
-                    }
-                    if (valid[1]) {
-                        can_block.can_->send(frame[1]);
-                    }
-                    if (valid[2]) {
-                        can_block.can_->send(frame[2]);
+                    auto stamp = motor->sample_time();
+                    if (oldest == Device::DeviceBase::time_point{} || stamp < oldest) {
+                        oldest = stamp;
                     }
                 }
-                data_lock.unlock();
-                std::this_thread::sleep_until(now + std::chrono::milliseconds(1));
             }
+            return oldest;
         }
 
-        void start() {
-            task_handle = std::thread(task);
+        void tick() {
+            std::unique_lock lock(data_lock);
+            for (auto &[can_name, can_block]: motors_map) {
+                if (can_block.can_ == nullptr) {
+                    can_block.can_ = IO::io<CAN>[can_name];
+                }
+                if (can_block.can_ == nullptr || can_block.motors_.empty()) {
+                    continue;
+                }
+                if (can_block.packer_) {
+                    can_block.packer_(*can_block.can_, can_block.motors_);
+                } else {
+                    pack_classic(*can_block.can_, can_block.motors_);
+                }
+            }
         }
     }
 }
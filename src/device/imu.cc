@@ -1,12 +1,17 @@
 #include "device/imu.hpp"
 
 #include "io.hpp"
+#include "robot_type_config.hpp"
 #include "serial_interface.hpp"
 #include "user_lib.hpp"
 
 namespace Device
 {
-    IMU::IMU(const std::string &serial_name) : serial_name(serial_name) {
+    IMU::IMU(const std::string &serial_name)
+        : serial_name(serial_name),
+          history(UserLib::topic_bus.topic<Attitude, HISTORY>(
+              "imu." + serial_name,
+              std::chrono::milliseconds(Config::DEFAULT_OFFLINE_TIME))) {
     }
 
     void IMU::enable() {
@@ -16,10 +21,16 @@ namespace Device
             return;
         }
         serial_interface->register_callback<Types::ReceivePacket_IMU>(
-            [&](const Types::ReceivePacket_IMU &rp) { unpack(rp); });
+            [this, serial_interface](const Types::ReceivePacket_IMU &rp) {
+                unpack(rp, serial_interface->rx_stamp());
+            });
         }
 
     void IMU::unpack(const Types::ReceivePacket_IMU &pkg) {
+        unpack(pkg, std::chrono::steady_clock::now());
+    }
+
+    void IMU::unpack(const Types::ReceivePacket_IMU &pkg, time_point stamp) {
         yaw = UserLib::rad_format(pkg.yaw * (M_PIf / 180));
         pitch = -UserLib::rad_format(pkg.pitch * (M_PIf / 180));
         roll = UserLib::rad_format(pkg.roll * (M_PIf / 180));
@@ -28,6 +39,65 @@ namespace Device
         roll_rate = pkg.roll_v * (M_PIf / 180) / 1000;
         // if (serial_name.compare("/dev/IMU_HERO") == 0)
         //     LOG_INFO("imu %.6f %.6f %.6f\n", pkg.yaw, pkg.pitch, pkg.yaw_v);
-        update_time();
+        history.publish(
+            { stamp,
+              UserLib::Quaternion::from_euler(yaw, pitch, roll),
+              yaw,
+              pitch,
+              roll,
+              yaw_rate,
+              pitch_rate,
+              roll_rate },
+            stamp);
+        update_time(stamp);
+    }
+
+    // false when the slot is being rewritten or already holds a newer sample
+    bool IMU::read(uint64_t index, Attitude &out) const {
+        return history.read(index, [&](const Topic::Message &message) { out = message.data; });
+    }
+
+    std::optional<IMU::Attitude> IMU::attitude_at(time_point t) const {
+        uint64_t end = history.published();
+        Attitude after;
+        if (end == 0 || !read(end - 1, after)) {
+            return std::nullopt;
+        }
+        if (t >= after.time) {
+            return after;
+        }
+
+        // first sample newer than t, the oldest slot may be overwritten while we search
+        uint64_t lo = end > HISTORY ? end - HISTORY + 1 : 0;
+        uint64_t hi = end - 1;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            Attitude probe;
+            if (!read(mid, probe) || probe.time <= t) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+                after = probe;
+            }
+        }
+        Attitude before;
+        if (hi == 0 || !read(hi - 1, before) || before.time > t) {
+            return std::nullopt;
+        }
+
+        const auto &a = before;
+        const auto &b = after;
+        fp32 k = std::chrono::duration<fp32>(t - a.time) /
+                 std::chrono::duration<fp32>(b.time - a.time);
+        Attitude out;
+        out.time = t;
+        out.q = UserLib::Quaternion::slerp(a.q, b.q, k);
+        out.yaw = out.q.yaw();
+        out.pitch = out.q.pitch();
+        out.roll = out.q.roll();
+        out.yaw_rate = a.yaw_rate + (b.yaw_rate - a.yaw_rate) * k;
+        out.pitch_rate = a.pitch_rate + (b.pitch_rate - a.pitch_rate) * k;
+        out.roll_rate = a.roll_rate + (b.roll_rate - a.roll_rate) * k;
+        return out;
     }
 }  // namespace Device
@@ -45,131 +45,136 @@ namespace Device
     // }
     // delta++;
 
-#ifndef CONFIG_SENTRY 
-        float vx = 0, vy = 0;
-        float speed = 1;
+        static bool wz_key_pressed_last = false;
+        static bool friction_key_pressed_last = false;
+        static bool use_key = false;
+        bool keyboard = false;
 
-        if (pkg.key & KEY_D) {
-            vx++;
-        }
-        if (pkg.key & KEY_A) {
-            vx--;
-        }
-        if (pkg.key & KEY_S) {
-            vy--;
-        }
-        if (pkg.key & KEY_W) {
-            vy++;
-        }
+        // 只有这个回调写 rc，整包在自己的副本上改完再一次发布
+        robot_set->rc.update([&](Robot::RcInput &input) {
+            input.packets++;
+            input.pitch_absolute = false;
 
-        robot_set->vx_set = vx * speed;
-        robot_set->vy_set = vy * speed;
+#ifndef CONFIG_SENTRY 
+            float vx = 0, vy = 0;
+            float speed = 1;
 
-        if (pkg.key) {
-            LOG_INFO("key : %d\n", pkg.key);
-        }
+            if (pkg.key & KEY_D) {
+                vx++;
+            }
+            if (pkg.key & KEY_A) {
+                vx--;
+            }
+            if (pkg.key & KEY_S) {
+                vy--;
+            }
+            if (pkg.key & KEY_W) {
+                vy++;
+            }
 
-        static bool wz_key_pressed_last = false;
-        static bool friction_key_pressed_last = false;
+            input.vx_set = vx * speed;
+            input.vy_set = vy * speed;
 
-        // 切换自旋状态
-        if (pkg.key & KEY_R) {
-            if (!wz_key_pressed_last) {
-                robot_set->wz_set = 1 - robot_set->wz_set;
+            if (pkg.key) {
+                LOG_INFO("key : %d\n", pkg.key);
             }
-            wz_key_pressed_last = true;
-        } else {
-            wz_key_pressed_last = false;
-        }
 
-        // 切换摩擦轮状态
-        if (pkg.key & KEY_F) {
-            if (!friction_key_pressed_last) {
-                robot_set->friction_open = !robot_set->friction_open;
+            // 切换自旋状态
+            if (pkg.key & KEY_R) {
+                if (!wz_key_pressed_last) {
+                    input.wz_set = 1 - input.wz_set;
+                }
+                wz_key_pressed_last = true;
+            } else {
+                wz_key_pressed_last = false;
             }
-            friction_key_pressed_last = true;
-        } else {
-            friction_key_pressed_last = false;
-        }
 
+            // 切换摩擦轮状态
+            if (pkg.key & KEY_F) {
+                if (!friction_key_pressed_last) {
+                    input.friction_open = !input.friction_open;
+                }
+                friction_key_pressed_last = true;
+            } else {
+                friction_key_pressed_last = false;
+            }
 
-        if (pkg.mouse_r || (pkg.s1 == S1_DOWN && pkg.s2 == S2_UP)) {
-            robot_set->auto_aim_status = true;
-            // LOG_INFO("auto aim status : %d\n", pkg.s1);
-        } else {
-            robot_set->auto_aim_status = false;
-        }
 
-        if (pkg.mouse_l || pkg.ch4 == ROLL_DOWN_MAX) {
-            robot_set->shoot_open = SHOOT_PERMISSION_GIMBAL1;
-        } else {
-            robot_set->shoot_open = SHOOT_PERMISSION_NONE;
-        }
+            if (pkg.mouse_r || (pkg.s1 == S1_DOWN && pkg.s2 == S2_UP)) {
+                input.auto_aim_status = true;
+                // LOG_INFO("auto aim status : %d\n", pkg.s1);
+            } else {
+                input.auto_aim_status = false;
+            }
 
-        if (!robot_set->auto_aim_status) {
-            robot_set->gimbalT_1_yaw_set += pkg.mouse_x / 10000.;
-            robot_set->gimbalT_1_pitch_set += pkg.mouse_y / 10000.;
-            robot_set->gimbalT_1_pitch_set =
-                std::clamp(robot_set->gimbalT_1_pitch_set, -0.3f, 0.3f); 
-        }
+            if (pkg.mouse_l || pkg.ch4 == ROLL_DOWN_MAX) {
+                input.shoot_open = SHOOT_PERMISSION_GIMBAL1;
+            } else {
+                input.shoot_open = SHOOT_PERMISSION_NONE;
+            }
+
+            // 云台循环叠加增量并把 pitch 限制在 ±0.3
+            if (!input.auto_aim_status) {
+                input.yaw_offset += pkg.mouse_x / 10000.;
+                input.pitch_offset += pkg.mouse_y / 10000.;
+            }
 
 
 
 
 #endif
 
-        static bool use_key = false;
-        if (pkg.key & KEY_PRESS) {
-            use_key = true;
-        }
+            if (pkg.key & KEY_PRESS) {
+                use_key = true;
+            }
 
-        if (use_key) {
-            return; 
-        }
+            if (use_key) {
+                keyboard = true;
+                return; 
+            }
             
 
-        // auto-aim, disable control
-        // if (pkg.s1 == S1_DOWN) {
-        //     return; 
-        // }
-        if (inited) {
-            // LOG_INFO("rc controller ch1 %d %d %d %d\n", pkg.s1, pkg.s2, pkg.ch1, pkg.ch3);
-            robot_set->vx_set = ((float)pkg.ch3 / RC_SCALE) * CHASSIS_SPEED_SCALE;
-            robot_set->vy_set = ((float)pkg.ch2 / RC_SCALE) * CHASSIS_SPEED_SCALE;
-
-            if (robot_set->mode == Types::ROBOT_MODE::ROBOT_SEARCH) {
-                robot_set->gimbal_sentry_yaw_set += ((float)pkg.ch0 / RC_SCALE) * GIMBAL_YAW_SENSITIVITY;
-            } else {
-                robot_set->gimbalT_1_yaw_set += ((float)pkg.ch0 / RC_SCALE) * GIMBAL_YAW_SENSITIVITY;
-                robot_set->gimbalT_1_pitch_set = ((float)pkg.ch1 / RC_SCALE) * GIMBAL_PITCH_SENSITIVITY;
-                
-                IFDEF(CONFIG_SENTRY, robot_set->gimbalT_2_yaw_set = robot_set->gimbalT_1_yaw_set;
-                    robot_set->gimbalT_2_pitch_set = robot_set->gimbalT_1_pitch_set;)
+            // auto-aim, disable control
+            // if (pkg.s1 == S1_DOWN) {
+            //     return; 
+            // }
+            if (inited) {
+                // LOG_INFO("rc controller ch1 %d %d %d %d\n", pkg.s1, pkg.s2, pkg.ch1, pkg.ch3);
+                input.vx_set = ((float)pkg.ch3 / RC_SCALE) * CHASSIS_SPEED_SCALE;
+                input.vy_set = ((float)pkg.ch2 / RC_SCALE) * CHASSIS_SPEED_SCALE;
+
+                // SEARCH 时给哨兵大 yaw，否则给云台 1 (哨兵的云台 2 照搬)，由云台循环按模式取用
+                input.yaw_offset += ((float)pkg.ch0 / RC_SCALE) * GIMBAL_YAW_SENSITIVITY;
+                input.pitch_absolute = true;
+                input.pitch_set = ((float)pkg.ch1 / RC_SCALE) * GIMBAL_PITCH_SENSITIVITY;
+
+                if (pkg.s1 == S1_UP)
+                    input.wz_set = 1.0;
+                else
+                    input.wz_set = 0;
+
+                if (pkg.s2 == S2_UP)
+                    input.friction_open = true;
+                else
+                    input.friction_open = false;
+
+                IFDEF(
+                    CONFIG_SENTRY,
+                    if (pkg.s2 == S2_DOWN) {
+                        input.sentry_follow_gimbal = true;
+                        input.friction_open = true;
+                        if (pkg.ch4 == ROLL_DOWN_MAX)
+                            input.shoot_open = SHOOT_PERMISSION_BOTH;
+                        else
+                            input.shoot_open = SHOOT_PERMISSION_NONE;
+                    } else {
+                        input.sentry_follow_gimbal = false;
+                        input.friction_open = false;
+                    })
             }
-
-            if (pkg.s1 == S1_UP)
-                robot_set->wz_set = 1.0;
-            else
-                robot_set->wz_set = 0;
-
-            if (pkg.s2 == S2_UP)
-                robot_set->friction_open = true;
-            else
-                robot_set->friction_open = false;
-
-            IFDEF(
-                CONFIG_SENTRY,
-                if (pkg.s2 == S2_DOWN) {
-                    robot_set->sentry_follow_gimbal = true;
-                    robot_set->friction_open = true;
-                    if (pkg.ch4 == ROLL_DOWN_MAX)
-                        robot_set->shoot_open = SHOOT_PERMISSION_BOTH;
-                    else
-                        robot_set->shoot_open = SHOOT_PERMISSION_NONE;
-                } else {
-                    robot_set->sentry_follow_gimbal = false;
-                    robot_set->friction_open = false;
-                })
+        });
+        if (keyboard) {
+            return;
         }
         update_time();
     }
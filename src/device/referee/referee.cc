@@ -36,6 +36,17 @@ namespace Device
         robot_set = robot;
     }
 
+    template<typename T>
+    void Dji_referee::receive(
+        const uint8_t *data,
+        T Types::Referee_info::*field,
+        Topic<T> &topic) {
+        T message;
+        memcpy(&message, data, sizeof(T));
+        robot_set->referee_info.update([&](Types::Referee_info &info) { info.*field = message; });
+        topic.publish(message);
+    }
+
     int Dji_referee::unpack(uint8_t *rx_data) {
         uint16_t cmd_id;
         int frame_len;
@@ -59,34 +70,34 @@ namespace Device
                 cmd_id = (rx_data[6] << 8 | rx_data[5]);
                 switch (cmd_id) {
                     case Referee::RefereeCmdId::GAME_STATUS_CMD: {
-                        memcpy(
-                            &robot_set->referee_info.game_status_data,
+                        receive(
                             rx_data + 7,
-                            sizeof(Referee::GameStatus));
+                            &Types::Referee_info::game_status_data,
+                            game_status_topic);
 
                         // printf("game status\n");
                         break;
                     }
                     case Referee::RefereeCmdId::GAME_RESULT_CMD: {
-                        memcpy(
-                            &robot_set->referee_info.game_result_ref,
+                        receive(
                             rx_data + 7,
-                            sizeof(Referee::GameResult));
+                            &Types::Referee_info::game_result_ref,
+                            game_result_topic);
                         // printf("game result\n");
                         break;
                     }
                     case Referee::RefereeCmdId::REFEREE_WARNING_CMD: {
-                        memcpy(
-                            &robot_set->referee_info.referee_warning_ref,
+                        receive(
                             rx_data + 7,
-                            sizeof(Referee::RefereeWarning));
+                            &Types::Referee_info::referee_warning_ref,
+                            warning_topic);
                         break;
                     }
                     case Referee::RefereeCmdId::ROBOT_STATUS_CMD: {
-                        memcpy(
-                            &robot_set->referee_info.game_robot_status_data,
+                        receive(
                             rx_data + 7,
-                            sizeof(Referee::GameRobotStatus));
+                            &Types::Referee_info::game_robot_status_data,
+                            robot_status_topic);
                         // LOG_INFO(
                         //     "robot status chassis power limit: %d %d\n",
                         //     robot_set->referee_info.game_robot_status_data.chassis_power_limit,
@@ -94,20 +105,20 @@ namespace Device
                         break;
                     }
                     case Referee::RefereeCmdId::POWER_HEAT_DATA_CMD: {
-                        memcpy(
-                            &robot_set->referee_info.power_heat_data,
+                        receive(
                             rx_data + 7,
-                            sizeof(Referee::PowerHeatData));
+                            &Types::Referee_info::power_heat_data,
+                            power_heat_topic);
                         // printf(
                         //     "power heat %d\n",
                         //     robot_set->referee_info.power_heat_data.chassis_power_buffer);
                         break;
                     }
                     case Referee::RefereeCmdId::BULLET_REMAINING_CMD: {
-                        memcpy(
-                            &robot_set->referee_info.bullet_allowance_data,
+                        receive(
                             rx_data + 7,
-                            sizeof(Referee::BulletAllowance));
+                            &Types::Referee_info::bullet_allowance_data,
+                            bullet_allowance_topic);
                         // printf("bullet remaining \n");
                         break;
                     }
@@ -125,22 +136,25 @@ namespace Device
     void Dji_referee::task() {
         while (1) {
             read();
+            auto referee = robot_set->referee_info.load();
             bool referee_fire_allowance = MUXDEF(
                 CONFIG_HERO,
-                robot_set->referee_info.bullet_allowance_data.bullet_allowance_num_42_mm > 0,
-                robot_set->referee_info.bullet_allowance_data.bullet_allowance_num_17_mm > 0);
+                referee.bullet_allowance_data.bullet_allowance_num_42_mm > 0,
+                referee.bullet_allowance_data.bullet_allowance_num_17_mm > 0);
             // LOG_INFO("ui update\n");
             update_ui_data(
                 &base_,
                 robot_set->friction_real_state && referee_fire_allowance,
-                robot_set->cv_fire,
+                robot_set->inputs().cv_fire(),
                 robot_set->spin_state,
-                ((float)robot_set->super_cap_info.capEnergy / 250) * 100);
+                ((float)robot_set->super_cap_info.load().capEnergy / 250) * 100);
             std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
     }
 
     void Dji_referee::task_ui() {
-        custom_ui_task(&base_, robot_set->referee_info.game_robot_status_data.robot_id);
+        custom_ui_task(&base_, [this] {
+            return robot_set->referee_info.load().game_robot_status_data.robot_id;
+        });
     }
 }  // namespace Device
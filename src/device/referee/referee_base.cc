@@ -47,16 +47,9 @@ namespace Device
     }
 
     uint16_t Base::getCRC16CheckSum(uint8_t *pch_message, uint32_t dw_length, uint16_t w_crc) {
-        uint8_t chData;
         if (pch_message == nullptr)
             return 0xFFFF;
-        while (dw_length--) {
-            chData = *pch_message++;
-            (w_crc) = (static_cast<uint16_t>(w_crc) >> 8) ^
-                      Referee::wCRC_table
-                          [(static_cast<uint16_t>(w_crc) ^ static_cast<uint16_t>(chData)) & 0x00ff];
-        }
-        return w_crc;
+        return Referee::crc16(pch_message, dw_length, w_crc);
     }
 
     uint32_t Base::verifyCRC16CheckSum(uint8_t *pch_message, uint32_t dw_length) {
@@ -11,13 +11,18 @@ namespace Device
         robot_set = robot;
         can = IO::io<CAN>[can_name];
         can->register_callback_key(
-            0x51, std::bind(&Super_Cap::unpack, this, std::placeholders::_1));
+            0x51,
+            [](void* ctx, const can_frame& frame) {
+                auto cap = static_cast<Super_Cap*>(ctx);
+                cap->unpack(frame, cap->can->rx_stamp());
+            },
+            this);
     }
 
-    void Super_Cap::unpack(const can_frame& frame) {
+    void Super_Cap::unpack(const can_frame& frame, time_point stamp) {
         static int delta = 0;
         delta++;
-        uint16_t robot_level = robot_set->referee_info.game_robot_status_data.robot_level;
+        uint16_t robot_level = robot_set->referee_info.load().game_robot_status_data.robot_level;
         uint16_t power_limit = MUXDEF(
             CONFIG_HERO,
             Power::HeroChassisPowerLimit_HP_FIRST[robot_level] * 0.9,
@@ -31,7 +36,10 @@ namespace Device
             delta = 0;
         }
 
-        std::memcpy(&robot_set->super_cap_info, frame.data, 8);
+        Types::ReceivePacket_Super_Cap info;
+        std::memcpy(&info, frame.data, sizeof(info));
+        robot_set->super_cap_info.store(info);
+        update_time(stamp);
 
         // LOG_INFO(
         //     "errorCode %d\tchassisPower %f\tchassisPowerlimit %d\tcapEnergy %d power limit %d\n",
@@ -45,7 +53,7 @@ namespace Device
     void Super_Cap::set(bool enable, uint16_t power_limit) {
         can_frame send{};
         uint16_t chassis_power_buffer =
-            robot_set->referee_info.power_heat_data.chassis_power_buffer;
+            robot_set->referee_info.load().power_heat_data.chassis_power_buffer;
         send.can_id = 0x061;
         send.can_dlc = 8;
         if (enable)
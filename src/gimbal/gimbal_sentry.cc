@@ -28,7 +28,6 @@ namespace Gimbal
             Pid::Invert(-1);
 
         yaw_motor.setCtrl(Pid::PidPosition(config.yaw_rate_pid_config, imu.yaw_rate));
-        yaw_set = &robot_set->gimbal_sentry_yaw_set;
 
         imu.enable();
         yaw_motor.enable();
@@ -46,10 +45,11 @@ namespace Gimbal
     void GimbalSentry::init_task() {
         while (robot_set->inited != Types::Init_status::INIT_FINISH) {
             update_data();
+            rc_seen = robot_set->rc.load();
             0.f >> yaw_relative_pid >> yaw_motor;
             // LOG_INFO("big yaw %d %f\n", yaw_motor.motor_measure.ecd, yaw_relative);
             // LOG_INFO("yaw r %f\n", yaw_relative);
-            *yaw_set = imu.yaw;
+            yaw_set = imu.yaw;
             if (fabs(yaw_relative) < Config::GIMBAL_INIT_EXP) {
                 init_stop_times += 1;
             } else {
@@ -61,38 +61,36 @@ namespace Gimbal
         }
     }
 
-    [[noreturn]] void GimbalSentry::task() {
-        while (true) {
-            update_data();
-            switch (robot_set->mode) {
-                case Types::ROBOT_MODE::ROBOT_NO_FORCE: 0 >> yaw_motor; break;
-                case Types::ROBOT_MODE::ROBOT_FINISH_INIT:
-                case Types::ROBOT_MODE::ROBOT_IDLE:
-                case Types::ROBOT_MODE::ROBOT_SEARCH:
-                    *yaw_set >> yaw_absolute_pid >> yaw_motor;
-                    break;
-                default: 0.f >> yaw_relative_with_two_head_pid >> yaw_motor; break;
-            };
-
-            Robot::SendNavigationInfo gimbal_info;
-            gimbal_info.header = 0x37;
-            gimbal_info.yaw = imu.yaw;
-            gimbal_info.pitch = imu.pitch;
-            gimbal_info.hp = robot_set->referee_info.game_robot_status_data.remain_hp * 1. /
-                             robot_set->referee_info.game_robot_status_data.max_hp;
-            gimbal_info.start =
-                (robot_set->referee_info.game_status_data.game_progress & 0x0f) == 4;
-
-            // FIXME: random robot_set used
-            if (gimbal_info.start) {
-                robot_set->wz_set = 0.3;
-                robot_set->friction_open = true;
-            }
-            // LOG_INFO("game progress %d\n", robot_set->referee_info.game_status_data.game_progress
-            // & 0x0f); IO::io<SOCKET>["AUTO_AIM_CONTROL"]->send(gimbal_info);
-
-            UserLib::sleep_ms(Config::GIMBAL_CONTROL_TIME);
+    void GimbalSentry::tick() {
+        auto in = robot_set->inputs();
+        auto mode = in.mode();
+        update_data();
+        if (mode == Types::ROBOT_MODE::ROBOT_SEARCH && in.rc.packets != rc_seen.packets) {
+            yaw_set += in.rc.yaw_offset - rc_seen.yaw_offset;
         }
+        rc_seen = in.rc;
+        switch (mode) {
+            case Types::ROBOT_MODE::ROBOT_NO_FORCE: 0 >> yaw_motor; break;
+            case Types::ROBOT_MODE::ROBOT_FINISH_INIT:
+            case Types::ROBOT_MODE::ROBOT_IDLE:
+            case Types::ROBOT_MODE::ROBOT_SEARCH:
+                yaw_set >> yaw_absolute_pid >> yaw_motor;
+                break;
+            default: 0.f >> yaw_relative_with_two_head_pid >> yaw_motor; break;
+        };
+
+        // the send below is disabled, the packet is still filled in
+        [[maybe_unused]] Robot::SendNavigationInfo gimbal_info;
+        gimbal_info.header = 0x37;
+        gimbal_info.yaw = imu.yaw;
+        gimbal_info.pitch = imu.pitch;
+        auto referee = robot_set->referee_info.load();
+        gimbal_info.hp = referee.game_robot_status_data.remain_hp * 1. /
+                         referee.game_robot_status_data.max_hp;
+        // 开赛后的自旋和摩擦轮由 Inputs::wz_set / friction_open 给出
+        gimbal_info.start = in.game_started;
+        // LOG_INFO("game progress %d\n", robot_set->referee_info.game_status_data.game_progress
+        // & 0x0f); IO::io<SOCKET>["AUTO_AIM_CONTROL"]->send(gimbal_info);
     }
 
     void GimbalSentry::update_data() {
@@ -100,9 +98,8 @@ namespace Gimbal
         yaw_relative = UserLib::rad_format(
             Config::M9025_ECD_TO_RAD *
             ((fp32)yaw_motor.motor_measure.ecd - Config::GIMBAL3_YAW_OFFSET_ECD));
-        yaw_relative_with_two_head =
-            robot_set->gimbalT_1_yaw_reletive + robot_set->gimbalT_2_yaw_reletive;
-        robot_set->gimbal_sentry_yaw_reletive = yaw_relative;
-        robot_set->gimbal_sentry_yaw = imu.yaw;
+        yaw_relative_with_two_head = robot_set->gimbalT_1_state.load().yaw_relative +
+                                     robot_set->gimbalT_2_state.load().yaw_relative;
+        robot_set->gimbal_sentry_state.store({ imu.yaw, yaw_relative });
     }
 }  // namespace Gimbal
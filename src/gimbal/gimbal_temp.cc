@@ -18,31 +18,12 @@ namespace Gimbal
           imu(config.imu_serial_port),
           yaw_motor(config.yaw_motor_config),
           pitch_motor(config.pitch_motor_config),
-          yaw_set(nullptr),
-          another_yaw_set(nullptr),
-          another_pitch_set(nullptr),
-          pitch_set(nullptr),
-          yaw_rela(nullptr),
           shoot(config.shoot_config) {
-        receive_auto_aim = std::chrono::steady_clock::now();
     }
 
     void GimbalT::init(const std::shared_ptr<Robot::Robot_set> &robot) {
         robot_set = robot;
         shoot.init(robot);
-        if (config.gimbal_id == 1) {
-            yaw_set = &robot_set->gimbalT_1_yaw_set;
-            another_yaw_set = &robot_set->gimbalT_2_yaw_set;
-            another_pitch_set = &robot_set->gimbalT_2_pitch_set;
-            pitch_set = &robot_set->gimbalT_1_pitch_set;
-            yaw_rela = &robot_set->gimbalT_1_yaw_reletive;
-        } else {
-            yaw_set = &robot_set->gimbalT_2_yaw_set;
-            another_yaw_set = &robot_set->gimbalT_1_yaw_set;
-            another_pitch_set = &robot_set->gimbalT_1_pitch_set;
-            pitch_set = &robot_set->gimbalT_2_pitch_set;
-            yaw_rela = &robot_set->gimbalT_2_yaw_reletive;
-        }
 
         yaw_motor.setCtrl(Pid::PidPosition(config.yaw_rate_pid_config, yaw_gyro));
         pitch_motor.setCtrl(
@@ -63,10 +44,16 @@ namespace Gimbal
         yaw_motor.enable();
         pitch_motor.enable();
 
-        IO::io<SOCKET>["AUTO_AIM_CONTROL"]->add_client(
-            config.header, config.auto_aim_ip, config.auto_aim_port);
+        auto_aim_socket = IO::io<SOCKET>["AUTO_AIM_CONTROL"];
+        auto_aim_client =
+            auto_aim_socket->add_client(config.header, config.auto_aim_ip, config.auto_aim_port);
+        auto_aim_socket->set_max_command_age(
+            std::chrono::milliseconds(Config::AUTO_AIM_MAX_AGE_MS));
 
-        IO::io<SOCKET>["AUTO_AIM_CONTROL"]->register_callback_key(
+        // single writer: the socket serializes its UDP and shm dispatch
+        aim_topic = &UserLib::topic_bus.topic<Robot::Auto_aim_control>(
+            "vision.gimbal" + std::to_string(config.gimbal_id), Robot::VISION_TIMEOUT);
+        auto_aim_socket->register_callback_key(
             config.header, [this](const Robot::Auto_aim_control &vc) {
                 LOG_INFO(
                     "socket recive %f %f %d %d\n",
@@ -74,47 +61,67 @@ namespace Gimbal
                     vc.pitch_set,
                     vc.fire,
                     config.gimbal_id);
-                receive_auto_aim = std::chrono::steady_clock::now();
-                if (vc.fire == false)
-                    return;
-                robot_set->set_mode(Types::ROBOT_MODE::ROBOT_FOLLOW_GIMBAL);
-                robot_set->cv_fire = true;
-                if (vc.fire && ISDEF(CONFIG_SENTRY)) {
-                    robot_set->shoot_open |= config.gimbal_id;
-                }
-
-                if ((robot_set->shoot_open & (3 - config.gimbal_id)) == 0) {
-                    *another_yaw_set = vc.yaw_set;
-                    *another_pitch_set = vc.pitch_set;
-                }
-
-                // if (!ISDEF(CONFIG_SENTRY) && !robot_set->auto_aim_status)
-                //     return;
-                *yaw_set = vc.yaw_set;
-                *pitch_set = vc.pitch_set;
+                aim_topic->publish(vc);
+                // 只发布本云台的视觉输入，开火、射击权限、模式和设定值由各循环在 Inputs 里合并
+                robot_set->vision(config.gimbal_id).update([&](Robot::VisionInput &input) {
+                    auto now = Robot::input_now_ns();
+                    if (now - input.stamp_ns >=
+                        std::chrono::nanoseconds(Robot::VISION_TIMEOUT).count()) {
+                        input.firing = false;
+                    }
+                    input.stamp_ns = now;
+                    if (vc.fire == false)
+                        return;
+                    input.firing = true;
+                    input.commands++;
+                    input.yaw_set = vc.yaw_set;
+                    input.pitch_set = vc.pitch_set;
+                });
             });
+    }
 
-        std::thread check_auto_aim([this] {
-            while (true) {
-                if (robot_set->sentry_follow_gimbal) {
-                    IFDEF(
-                        CONFIG_SENTRY, robot_set->set_mode(Types::ROBOT_MODE::ROBOT_FOLLOW_GIMBAL));
-                    continue;
-                }
-                if (std::chrono::steady_clock::now() - receive_auto_aim >
-                    std::chrono::milliseconds(300)) {
-                    robot_set->shoot_open &= ~config.gimbal_id;
-                    robot_set->cv_fire = false;
-                }
-                // LOG_INFO("shoot open %d\n", robot_set->shoot_open);
-                if (robot_set->shoot_open == 0) {
-                    IFDEF(CONFIG_SENTRY, robot_set->set_mode(Types::ROBOT_MODE::ROBOT_SEARCH));
+    void GimbalT::apply_inputs(const Robot::Inputs &in) {
+        // RC 的增量叠加到云台 1 的设定值上，哨兵的云台 2 随后照搬云台 1 的设定值
+        bool manual = in.mode() != Types::ROBOT_MODE::ROBOT_SEARCH;
+        if (config.gimbal_id == 1) {
+            if (manual && in.rc.packets != rc_seen.packets) {
+                yaw_set += in.rc.yaw_offset - rc_seen.yaw_offset;
+                if (in.rc.pitch_absolute) {
+                    pitch_set = in.rc.pitch_set;
+                } else if (in.rc.pitch_offset != rc_seen.pitch_offset) {
+                    pitch_set = std::clamp(
+                        pitch_set + in.rc.pitch_offset - rc_seen.pitch_offset, -0.3f, 0.3f);
                 }
-                UserLib::sleep_ms(10);
+                robot_set->gimbalT_1_state.update([&](Robot::GimbalState &state) {
+                    state.yaw_set = yaw_set;
+                    state.pitch_set = pitch_set;
+                    state.rc_moves++;
+                });
             }
-        });
-
-        check_auto_aim.detach();
+        } else if (ISDEF(CONFIG_SENTRY)) {
+            auto leader = robot_set->gimbalT_1_state.load();
+            if (leader.rc_moves != rc_moves_seen) {
+                rc_moves_seen = leader.rc_moves;
+                yaw_set = leader.yaw_set;
+                pitch_set = leader.pitch_set;
+            }
+        }
+        rc_seen = in.rc;
+
+        // 视觉的新指令直接替换设定值: 先是另一个云台的 (本云台没有射击权限时)，再是自己的
+        int other = 3 - config.gimbal_id;
+        for (int id : { other, config.gimbal_id }) {
+            const auto &input = in.vision[id - 1];
+            if (input.commands == vision_seen[id - 1]) {
+                continue;
+            }
+            vision_seen[id - 1] = input.commands;
+            if (id == other && (in.shoot_open() & config.gimbal_id) != 0) {
+                continue;
+            }
+            yaw_set = input.yaw_set;
+            pitch_set = input.pitch_set;
+        }
     }
 
     void GimbalT::init_task() {
@@ -129,6 +136,8 @@ namespace Gimbal
         }
         while (robot_set->inited != Types::Init_status::INIT_FINISH) {
             update_data();
+            // 输入照常消费，设定值随后被归中覆盖
+            apply_inputs(robot_set->inputs());
             if (config.gimbal_id == 2) {
                 robot_set->inited |= 1 << 1;
             }
@@ -149,8 +158,8 @@ namespace Gimbal
                 init_stop_times = 0;
             }
 
-            MUXDEF(CONFIG_SENTRY, *yaw_set = robot_set->gimbal_sentry_yaw, *yaw_set = imu.yaw);
-            *pitch_set = 0;
+            MUXDEF(CONFIG_SENTRY, yaw_set = sentry_yaw, yaw_set = imu.yaw);
+            pitch_set = 0;
 
             if (init_stop_times >= Config::GIMBAL_INIT_STOP_TIME) {
                 if (config.gimbal_id == 1)
@@ -162,67 +171,71 @@ namespace Gimbal
         }
     }
 
-    [[noreturn]] void GimbalT::task() {
-        std::jthread shoot_thread(&Shoot::Shoot::task, &shoot);
-        while (true) {
-            update_data();
-            // LOG_INFO("%d: yaw set %f, imu yaw %f\n", config.header, *yaw_set, imu.yaw);
-            // logger.push_value("gimbal.yaw.set", (double)*yaw_set);
-            // logger.push_value("gimbal.yaw.imu", (double)imu.yaw);
-            if (robot_set->mode == Types::ROBOT_MODE::ROBOT_NO_FORCE) {
-                yaw_motor.give_current = 0;
-                pitch_motor.give_current = 0;
-            } else if (robot_set->mode == Types::ROBOT_MODE::ROBOT_SEARCH) {
-                static float delta = 0;
-                static float delta_1 = 0;
-
-                float yaw = (sin(delta) - 1) * (M_PIf / 2);
-                float pitch = sin(delta_1) * 0.30 + 0.165;
-                delta += 0.001;
-                delta_1 += 0.003;
-
-                if (config.gimbal_id == 1) {
-                    yaw >> yaw_relative_pid >> yaw_motor;
-                } else {
-                    -yaw >> yaw_relative_pid >> yaw_motor;
-                }
-                *pitch_set = std::clamp((double)pitch, -0.18, 0.51);
-                *pitch_set >> pitch_absolute_pid >> pitch_motor;
+    void GimbalT::tick() {
+        auto in = robot_set->inputs();
+        auto mode = in.mode();
+        update_data();
+        apply_inputs(in);
+        // LOG_INFO("%d: yaw set %f, imu yaw %f\n", config.header, yaw_set, imu.yaw);
+        // logger.push_value("gimbal.yaw.set", (double)yaw_set);
+        // logger.push_value("gimbal.yaw.imu", (double)imu.yaw);
+        if (mode == Types::ROBOT_MODE::ROBOT_NO_FORCE) {
+            yaw_motor.give_current = 0;
+            pitch_motor.give_current = 0;
+        } else if (mode == Types::ROBOT_MODE::ROBOT_SEARCH) {
+            static float delta = 0;
+            static float delta_1 = 0;
+
+            float yaw = (sin(delta) - 1) * (M_PIf / 2);
+            float pitch = sin(delta_1) * 0.30 + 0.165;
+            delta += 0.001;
+            delta_1 += 0.003;
+
+            if (config.gimbal_id == 1) {
+                yaw >> yaw_relative_pid >> yaw_motor;
             } else {
-                // NOTE: 抽象双头限位
-                MUXDEF(
-                    CONFIG_SENTRY, static float yr; static float ty;
-                    yr = -UserLib::rad_format(*yaw_set - robot_set->gimbal_sentry_yaw);
-                    if (config.gimbal_id == 1 && (yr < -2.6 || yr > 0.5)) {
-                        if (yr > 0)
-                            ty = robot_set->gimbal_sentry_yaw - (0.5);
-                        else
-                            ty = robot_set->gimbal_sentry_yaw - (-2.6);
-                    } else if (config.gimbal_id == 2 && (yr < -0.5 || yr > 2.6)) {
-                        if (yr > 0)
-                            ty = robot_set->gimbal_sentry_yaw - 2.6;
-                        else
-                            ty = robot_set->gimbal_sentry_yaw - (-0.5);
-                    } else { ty = *yaw_set; }
-
-                    ty >>
-                    yaw_absolute_pid >> yaw_motor;
-                    , *yaw_set >> yaw_absolute_pid >> yaw_motor;)
-
-                *pitch_set >> pitch_absolute_pid >> pitch_motor;
+                -yaw >> yaw_relative_pid >> yaw_motor;
             }
-            // if (config.gimbal_id == 1)
-            // LOG_INFO("%dpitch set %f\n", config.gimbal_id, *pitch_set);
-            // LOG_INFO("robot id % d\n", robot_set->referee_info.game_robot_status_data.robot_id);
-            Robot::SendAutoAimInfo pkg;
-            pkg.header = config.header;
-            MUXDEF(CONFIG_SENTRY, pkg.yaw = fake_yaw_abs, pkg.yaw = imu.yaw);
-            pkg.pitch = imu.pitch;
-            pkg.red = robot_set->referee_info.game_robot_status_data.robot_id < 100;
-            IO::io<SOCKET>["AUTO_AIM_CONTROL"]->send(pkg);
-
-            UserLib::sleep_ms(config.ControlTime);
+            pitch_set = std::clamp((double)pitch, -0.18, 0.51);
+            pitch_set >> pitch_absolute_pid >> pitch_motor;
+        } else {
+            // NOTE: 抽象双头限位
+            MUXDEF(
+                CONFIG_SENTRY, static float yr; static float ty;
+                yr = -UserLib::rad_format(yaw_set - sentry_yaw);
+                if (config.gimbal_id == 1 && (yr < -2.6 || yr > 0.5)) {
+                    if (yr > 0)
+                        ty = sentry_yaw - (0.5);
+                    else
+                        ty = sentry_yaw - (-2.6);
+                } else if (config.gimbal_id == 2 && (yr < -0.5 || yr > 2.6)) {
+                    if (yr > 0)
+                        ty = sentry_yaw - 2.6;
+                    else
+                        ty = sentry_yaw - (-0.5);
+                } else { ty = yaw_set; }
+
+                ty >>
+                yaw_absolute_pid >> yaw_motor;
+                , yaw_set >> yaw_absolute_pid >> yaw_motor;)
+
+            pitch_set >> pitch_absolute_pid >> pitch_motor;
         }
+        // if (config.gimbal_id == 1)
+        // LOG_INFO("%dpitch set %f\n", config.gimbal_id, pitch_set);
+        // LOG_INFO("robot id % d\n", robot_set->referee_info.game_robot_status_data.robot_id);
+        Robot::SendAutoAimInfo pkg;
+        pkg.header = config.header;
+        MUXDEF(CONFIG_SENTRY, pkg.yaw = fake_yaw_abs, pkg.yaw = imu.yaw);
+        pkg.pitch = imu.pitch;
+        pkg.red = robot_set->referee_info.load().game_robot_status_data.robot_id < 100;
+        pkg.seq = ++aim_info_seq;
+        aim_topic->latest([&](const auto &command) {
+            pkg.echo_seq = command.data.seq;
+            pkg.echo_ns = command.data.sent_ns;
+        });
+        pkg.sent_ns = UserLib::steady_ns();
+        auto_aim_socket->send(auto_aim_client, pkg);
     }
 
     void GimbalT::update_data() {
@@ -231,8 +244,12 @@ namespace Gimbal
         yaw_gyro = (std::cos(imu.pitch) * imu.yaw_rate - std::sin(imu.pitch) * imu.roll_rate);
         pitch_gyro = imu.pitch_rate;
         // gimbal sentry follow needs
-        *yaw_rela = yaw_relative;
-        fake_yaw_abs = robot_set->gimbal_sentry_yaw - yaw_relative;
+        robot_set->gimbal_state(config.gimbal_id).update([&](Robot::GimbalState &state) {
+            state.yaw = imu.yaw;
+            state.yaw_relative = yaw_relative;
+        });
+        sentry_yaw = robot_set->gimbal_sentry_state.load().yaw;
+        fake_yaw_abs = sentry_yaw - yaw_relative;
     }
 
 }  // namespace Gimbal
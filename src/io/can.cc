@@ -1,16 +1,42 @@
 #include "can.hpp"
 
+#include <linux/can/error.h>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
 #include <cstring>
+#include <fstream>
+#include <thread>
 
 #include "utils.hpp"
 
 namespace IO
 {
-    Can_interface::Can_interface(const std::string &name) : name(name) {
+    Can_interface::Can_interface(const std::string &name, bool offline) : name(name) {
         addr = new sockaddr_can;
         ifr = new ifreq;
         soket_id = -1;
         init_flag = false;
+        offline_mode = offline;
+        for (int i = 0; i < MAX_BATCH; i++) {
+            rx_iov[i] = { .iov_base = &rx_frames[i], .iov_len = sizeof(canfd_frame) };
+            rx_msgs[i] = {};
+            rx_msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+            rx_msgs[i].msg_hdr.msg_iovlen = 1;
+            rx_msgs[i].msg_hdr.msg_control = rx_control[i];
+        }
+        id_timing = std::make_unique<IdTiming[]>(CAN_SFF_MASK + 1);
+        if (offline_mode) {
+            LOG_INFO("CAN %s: offline, TX disabled\n", name.c_str());
+            return;
+        }
         init(name.c_str());
     }
 
@@ -32,33 +58,628 @@ namespace IO
             perror("Error in socket bind");
             exit(-1);
         }
+        // senders never block, frames the socket refuses wait in the TX queues
+        fcntl(soket_id, F_SETFL, fcntl(soket_id, F_GETFL) | O_NONBLOCK);
+        tx_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        // let the kernel stamp every frame on arrival
+        int stamping = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(soket_id, SOL_SOCKET, SO_TIMESTAMPING, &stamping, sizeof(stamping)) < 0) {
+            LOG_ERR("CAN error[%s]: can't enable SO_TIMESTAMPING\n", name.c_str());
+        }
+
+        // error frames bypass CAN_RAW_FILTER and are only delivered when asked for
+        can_err_mask_t err_mask = CAN_ERR_MASK;
+        if (setsockopt(soket_id, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask)) < 0) {
+            LOG_ERR("CAN error[%s]: can't set CAN_RAW_ERR_FILTER\n", name.c_str());
+        }
+
+        // nothing registered yet: let no frame through until a callback asks for its ID
+        rx_packets_base = interface_rx_packets();
+        last_window.time = std::chrono::steady_clock::now();
+        last_window.if_packets = interface_stat("rx_packets") + interface_stat("tx_packets");
+        last_window.if_bytes = interface_stat("rx_bytes") + interface_stat("tx_bytes");
+        apply_filter();
         init_flag = true;
     }
 
+    void Can_interface::register_callback_key(const uint32_t &key, Fn fn, void *ctx) {
+        Callback_key::register_callback_key(key, fn, ctx);
+        add_filter(key);
+    }
+
+    void Can_interface::register_callback_key(
+        const uint32_t &key, const std::function<void(const can_frame &)> &fun) {
+        Callback_key::register_callback_key(key, fun);
+        add_filter(key);
+    }
+
+    bool Can_interface::enable_fd() {
+        if (offline_mode) {
+            // replayed FD frames still reach the FD callbacks
+            fd_mode.store(true, std::memory_order_release);
+            return true;
+        }
+        int enable = 1;
+        if (setsockopt(soket_id, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) < 0) {
+            LOG_ERR("CAN error[%s]: can't enable CAN_RAW_FD_FRAMES\n", name.c_str());
+            return false;
+        }
+        fd_mode.store(true, std::memory_order_release);
+        LOG_OK("CAN %s: FD mode enabled\n", name.c_str());
+        return true;
+    }
+
+    bool Can_interface::fd_enabled() const {
+        return fd_mode.load(std::memory_order_acquire);
+    }
+
+    void Can_interface::register_fd_callback_key(uint32_t key, FdFn fn, void *ctx) {
+        fd_handlers.insert(key, fn, ctx);
+        add_filter(key);
+    }
+
+    static uint64_t steady_ns(Can_interface::time_point stamp) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(stamp.time_since_epoch())
+            .count();
+    }
+
+    bool Can_interface::start_capture(const std::string &path) {
+        auto writer = std::make_unique<CanTraceWriter>();
+        if (!writer->open(path, name)) {
+            return false;
+        }
+        stop_capture();
+        capture.store(writer.get(), std::memory_order_release);
+        capture_writers.push_back(std::move(writer));
+        LOG_OK("CAN %s: capture to %s\n", name.c_str(), path.c_str());
+        return true;
+    }
+
+    void Can_interface::stop_capture() {
+        if (auto writer = capture.exchange(nullptr)) {
+            writer->close();
+        }
+    }
+
+    Can_interface::ReplayResult Can_interface::replay(CanTraceReader &trace, bool paced) {
+        ReplayResult result;
+        CanTraceReader::Frame record;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t first_ts = 0;
+        trace.rewind();
+        while (trace.next(record)) {
+            if (record.tx) {
+                continue;
+            }
+            if (result.frames == 0) {
+                first_ts = record.ts_ns;
+            }
+            if (paced) {
+                auto offset = std::chrono::nanoseconds(record.ts_ns - first_ts);
+                std::this_thread::sleep_until(start + offset);
+            }
+            std::unique_lock guard(dispatch_lock);
+            rx_stamp_ = std::chrono::steady_clock::now();
+            result.frames++;
+            if (dispatch(record.frame, record.fd)) {
+                result.delivered++;
+            }
+        }
+        result.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    void Can_interface::add_filter(uint32_t key) {
+        std::unique_lock lock(filter_lock);
+        can_filter filter{};
+        filter.can_id = key;
+        filter.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG |
+                          ((key & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK);
+        for (const auto &other : filters) {
+            if (other.can_id == filter.can_id && other.can_mask == filter.can_mask) {
+                return;
+            }
+        }
+        filters.push_back(filter);
+        apply_filter();
+    }
+
+    // filter_lock must be held (or the socket not yet shared)
+    void Can_interface::apply_filter() {
+        if (soket_id < 0) {
+            return;
+        }
+        int res;
+        if (filters.size() > CAN_RAW_FILTER_MAX) {
+            // too many IDs for the kernel, fall back to receiving everything
+            can_filter all{ .can_id = 0, .can_mask = 0 };
+            res = setsockopt(soket_id, SOL_CAN_RAW, CAN_RAW_FILTER, &all, sizeof(all));
+        } else {
+            res = setsockopt(
+                soket_id,
+                SOL_CAN_RAW,
+                CAN_RAW_FILTER,
+                filters.empty() ? nullptr : filters.data(),
+                filters.size() * sizeof(can_filter));
+        }
+        if (res < 0) {
+            LOG_ERR("CAN error[%s]: can't set CAN_RAW_FILTER\n", name.c_str());
+        }
+    }
+
+    uint64_t Can_interface::interface_rx_packets() const {
+        return interface_stat("rx_packets");
+    }
+
+    uint64_t Can_interface::interface_stat(const char *stat) const {
+        std::ifstream file("/sys/class/net/" + name + "/statistics/" + stat);
+        uint64_t value = 0;
+        file >> value;
+        return value;
+    }
+
+    void Can_interface::set_bitrate(uint32_t rate) {
+        bitrate = rate;
+    }
+
+    void Can_interface::record_arrival(uint32_t can_id, time_point stamp) {
+        if (can_id > CAN_SFF_MASK) {
+            return;
+        }
+        auto &timing = id_timing[can_id];
+        int64_t now = steady_ns(stamp);
+        int64_t last = timing.last_ns.exchange(now, std::memory_order_relaxed);
+        if (last == 0 || now <= last) {
+            return;
+        }
+        uint64_t gap = (now - last) / 1000;
+        timing.gaps.fetch_add(1, std::memory_order_relaxed);
+        timing.gap_sum_us.fetch_add(gap, std::memory_order_relaxed);
+        timing.gap_sq_sum_us.fetch_add(gap * gap, std::memory_order_relaxed);
+        uint64_t prev = timing.max_gap_us.load(std::memory_order_relaxed);
+        while (prev < gap &&
+               !timing.max_gap_us.compare_exchange_weak(prev, gap, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Can_interface::record_error(const canfd_frame &frame) {
+        stats_.error_frames.fetch_add(1, std::memory_order_relaxed);
+        if (frame.can_id & CAN_ERR_BUSOFF) {
+            stats_.bus_off.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (frame.can_id & CAN_ERR_CRTL) {
+            stats_.controller_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (frame.can_id & (CAN_ERR_PROT | CAN_ERR_ACK | CAN_ERR_BUSERROR)) {
+            stats_.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Can_interface::diagnostics(const Publish &publish) {
+        Window now;
+        now.time = std::chrono::steady_clock::now();
+        now.rx_frames = stats_.rx_frames.load(std::memory_order_relaxed);
+        now.tx_frames = stats_.tx_frames.load(std::memory_order_relaxed);
+        now.rx_syscalls = stats_.rx_syscalls.load(std::memory_order_relaxed);
+        now.tx_syscalls = stats_.tx_syscalls.load(std::memory_order_relaxed);
+        now.tx_failures = stats_.tx_failures.load(std::memory_order_relaxed);
+        now.error_frames = stats_.error_frames.load(std::memory_order_relaxed);
+        now.bus_off = stats_.bus_off.load(std::memory_order_relaxed);
+        now.if_packets = interface_stat("rx_packets") + interface_stat("tx_packets");
+        now.if_bytes = interface_stat("rx_bytes") + interface_stat("tx_bytes");
+
+        double dt = std::chrono::duration<double>(now.time - last_window.time).count();
+        if (dt <= 0) {
+            return;
+        }
+        // standard data frame: 47 fixed bits (with 3 bit IFS) + 8 per byte, at most one stuff
+        // bit per 4 of the 34 stuffable header bits and of the payload
+        double packets = now.if_packets - last_window.if_packets;
+        double bytes = now.if_bytes - last_window.if_bytes;
+        double bits = packets * (47 + 34 / 4.0) + bytes * 10;
+
+        publish("rx_fps", (now.rx_frames - last_window.rx_frames) / dt);
+        publish("tx_fps", (now.tx_frames - last_window.tx_frames) / dt);
+        publish("load", bits / dt / bitrate);
+        publish("tx_fail", now.tx_failures - last_window.tx_failures);
+        publish("err", now.error_frames - last_window.error_frames);
+        publish("bus_off", now.bus_off - last_window.bus_off);
+        publish("rx_syscalls", (now.rx_syscalls - last_window.rx_syscalls) / dt);
+        publish("tx_syscalls", (now.tx_syscalls - last_window.tx_syscalls) / dt);
+        auto batch = [&](const std::string &key, const UserLib::Histogram &hist) {
+            if (hist.count() != 0) {
+                publish(key + "_p50", hist.percentile(0.5));
+                publish(key + "_max", hist.max());
+            }
+        };
+        batch("rx_batch", stats_.rx_batch);
+        batch("tx_batch", stats_.tx_batch);
+        if (stats_.rx_delay.count() != 0) {
+            publish("rx_delay_p50_us", stats_.rx_delay.percentile(0.5) / 1e3);
+            publish("rx_delay_p99_us", stats_.rx_delay.percentile(0.99) / 1e3);
+        }
+        last_window = now;
+
+        std::vector<uint32_t> keys;
+        {
+            std::unique_lock lock(filter_lock);
+            for (const auto &filter : filters) {
+                if (filter.can_id <= CAN_SFF_MASK) {
+                    keys.push_back(filter.can_id);
+                }
+            }
+        }
+        auto now_ns = steady_ns(now.time);
+        for (auto key : keys) {
+            auto &timing = id_timing[key];
+            uint64_t gaps = timing.gaps.exchange(0, std::memory_order_relaxed);
+            uint64_t sum = timing.gap_sum_us.exchange(0, std::memory_order_relaxed);
+            uint64_t sq_sum = timing.gap_sq_sum_us.exchange(0, std::memory_order_relaxed);
+            uint64_t max_gap = timing.max_gap_us.exchange(0, std::memory_order_relaxed);
+            int64_t last = timing.last_ns.load(std::memory_order_relaxed);
+
+            char prefix[16];
+            snprintf(prefix, sizeof(prefix), "0x%03X.", key);
+            double mean = gaps ? static_cast<double>(sum) / gaps : 0.;
+            double var = gaps ? static_cast<double>(sq_sum) / gaps - mean * mean : 0.;
+            publish(std::string(prefix) + "fps", gaps / dt);
+            publish(std::string(prefix) + "jitter_us", std::sqrt(std::max(var, 0.)));
+            publish(std::string(prefix) + "max_gap_ms", max_gap / 1e3);
+            publish(std::string(prefix) + "age_ms", last ? (now_ns - last) / 1e6 : -1.);
+        }
+    }
+
+    // frames the interface received that the kernel filter kept away from this socket
+    uint64_t Can_interface::filtered_frames() const {
+        uint64_t total = interface_rx_packets() - rx_packets_base;
+        uint64_t received = stats_.rx_frames.load(std::memory_order_relaxed);
+        return total > received ? total - received : 0;
+    }
+
     Can_interface::~Can_interface() {
+        stop_capture();
+        if (tx_event >= 0) {
+            close(tx_event);
+        }
+        if (tx_retry >= 0) {
+            close(tx_retry);
+        }
         delete addr;
         delete ifr;
     }
 
     bool Can_interface::task() {
         for (;;) {
-            if (init_flag) {
-                // read CAN frame
-                if (read(soket_id, &frame_r, sizeof(can_frame)) <= 0) {
+            if (!init_flag) {
+                continue;
+            }
+            // wait for POLLOUT only while frames are queued, ENOBUFS is not reported through
+            // poll so that case is retried on a short timeout instead
+            bool backlog = tx_backlog.load(std::memory_order_acquire);
+            bool nobufs = tx_nobufs.load(std::memory_order_relaxed);
+            pollfd fds[2] = {
+                { .fd = soket_id,
+                  .events = static_cast<short>(POLLIN | (backlog && !nobufs ? POLLOUT : 0)),
+                  .revents = 0 },
+                { .fd = tx_event, .events = POLLIN, .revents = 0 },
+            };
+            if (poll(fds, 2, backlog && nobufs ? TX_RETRY_MS : -1) < 0 && errno != EINTR) {
+                LOG_ERR("Error polling CAN socket");
+                return Status::ERROR;
+            }
+            if (fds[1].revents & POLLIN) {
+                uint64_t count;
+                read(tx_event, &count, sizeof(count));
+            }
+            if (fds[0].revents & POLLIN) {
+                int n;
+                while ((n = receive(MSG_DONTWAIT)) == MAX_BATCH) {
+                }
+                if (n < 0) {
                     LOG_ERR("Error reading CAN frame");
                     return Status::ERROR;
+                }
+            }
+            if (backlog) {
+                flush();
+            }
+        }
+    }
+
+    int Can_interface::fd() const {
+        return soket_id;
+    }
+
+    uint32_t Can_interface::reactor_events() const {
+        return EPOLLIN | EPOLLOUT;
+    }
+
+    void Can_interface::on_ready(uint32_t events) {
+        // edge triggered: drain everything the kernel has queued
+        if (events & EPOLLIN) {
+            int n;
+            while ((n = receive(MSG_DONTWAIT)) > 0) {
+            }
+            if (n < 0) {
+                LOG_ERR("Error reading CAN frame on %s\n", name.c_str());
+            }
+        }
+        if ((events & EPOLLOUT) && tx_backlog.load(std::memory_order_acquire)) {
+            flush();
+        }
+    }
+
+    void Can_interface::add_reactor_sources(Reactor &reactor) {
+        tx_retry = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (tx_event < 0 || tx_retry < 0) {
+            LOG_ERR("CAN error[%s]: no TX event/timer, backlog waits for EPOLLOUT\n", name.c_str());
+            return;
+        }
+        reactor.add(
+            name + ".tx_event",
+            tx_event,
+            [this](uint32_t) {
+                uint64_t count;
+                read(tx_event, &count, sizeof(count));
+                if (!tx_backlog.load(std::memory_order_acquire)) {
+                    return;
+                }
+                if (tx_nobufs.load(std::memory_order_relaxed)) {
+                    arm_tx_retry();
                 } else {
-                    // printf("not reading!\n");
+                    // the EPOLLOUT edge may have passed before the backlog was marked
+                    flush();
                 }
-                callback_key(frame_r.can_id, frame_r);
+            },
+            EPOLLIN);
+        reactor.add(
+            name + ".tx_retry",
+            tx_retry,
+            [this](uint32_t) {
+                uint64_t expirations;
+                read(tx_retry, &expirations, sizeof(expirations));
+                flush();
+                if (tx_backlog.load(std::memory_order_acquire) &&
+                    tx_nobufs.load(std::memory_order_relaxed)) {
+                    arm_tx_retry();
+                }
+            },
+            EPOLLIN);
+    }
+
+    void Can_interface::arm_tx_retry() {
+        itimerspec spec{};
+        spec.it_value.tv_nsec = TX_RETRY_MS * 1000000L;
+        timerfd_settime(tx_retry, 0, &spec, nullptr);
+    }
+
+    // kernel software stamps are CLOCK_REALTIME, move them onto the steady clock
+    static Can_interface::time_point kernel_stamp(
+        msghdr &msg,
+        const timespec &real_now,
+        Can_interface::time_point steady_now) {
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_TIMESTAMPING) {
+                continue;
+            }
+            scm_timestamping stamps;
+            memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+            const timespec &ts = stamps.ts[0];
+            auto age = std::chrono::seconds(real_now.tv_sec - ts.tv_sec) +
+                       std::chrono::nanoseconds(real_now.tv_nsec - ts.tv_nsec);
+            if (age.count() < 0) {
+                return steady_now;
+            }
+            return steady_now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age);
+        }
+        return steady_now;
+    }
+
+    // returns frames dispatched, 0 if nothing is pending, -1 on error
+    int Can_interface::receive(int flags) {
+        for (auto &msg : rx_msgs) {
+            msg.msg_hdr.msg_controllen = sizeof(rx_control[0]);
+        }
+        // read up to MAX_BATCH CAN frames in one syscall
+        int n = recvmmsg(soket_id, rx_msgs, MAX_BATCH, flags, nullptr);
+        stats_.rx_syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (n <= 0) {
+            return (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 0 : -1;
+        }
+        stats_.rx_frames.fetch_add(n, std::memory_order_relaxed);
+        stats_.rx_batch.record(n);
+
+        timespec real_now;
+        clock_gettime(CLOCK_REALTIME, &real_now);
+        auto steady_now = std::chrono::steady_clock::now();
+        std::unique_lock guard(dispatch_lock);
+        for (int i = 0; i < n; i++) {
+            rx_stamp_ = kernel_stamp(rx_msgs[i].msg_hdr, real_now, steady_now);
+            bool is_fd = rx_msgs[i].msg_len == CANFD_MTU;
+            if (rx_frames[i].can_id & CAN_ERR_FLAG) {
+                record_error(rx_frames[i]);
+                continue;
+            }
+            record_arrival(rx_frames[i].can_id, rx_stamp_);
+            if (auto writer = capture.load(std::memory_order_acquire)) {
+                writer->write(steady_ns(rx_stamp_), rx_frames[i], is_fd, false);
+            }
+            stats_.rx_delay.record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - rx_stamp_)
+                    .count());
+            if (is_fd) {
+                stats_.rx_fd_frames.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (dispatch(rx_frames[i], is_fd)) {
+                stats_.delivered.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                stats_.unmatched.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return n;
+    }
+
+    bool Can_interface::dispatch(const canfd_frame &frame, bool is_fd) {
+        if (is_fd) {
+            if (fd_handlers.dispatch(frame.can_id, frame)) {
+                return true;
+            }
+            if (frame.len > CAN_MAX_DLEN) {
+                return false;
             }
         }
+        // classic frames share the first CAN_MTU bytes of canfd_frame
+        can_frame classic{};
+        classic.can_id = frame.can_id;
+        classic.len = frame.len;
+        std::memcpy(classic.data, frame.data, std::min<size_t>(frame.len, CAN_MAX_DLEN));
+        return callback_key(classic.can_id, classic);
     }
 
-    bool Can_interface::send(const can_frame &frame) {
-        /* send CAN frame */
-        write(soket_id, &frame, sizeof(can_frame));
+    // tx_lock must be held
+    bool Can_interface::enqueue(const canfd_frame &frame, bool is_fd, TxPriority priority) {
+        // every send path passes here, so this one check keeps a replay off the bus
+        if (offline_mode) {
+            return false;
+        }
+        auto &queue = tx_queues[static_cast<int>(priority)];
+        for (size_t i = 0; i < queue.size; i++) {
+            auto &slot = queue.at(i);
+            if (slot.frame.can_id == frame.can_id) {
+                // keep the queue position, only the set-point is refreshed
+                slot = { frame, is_fd };
+                stats_.tx_coalesced.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        if (queue.size == TX_QUEUE_DEPTH) {
+            stats_.tx_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        queue.at(queue.size++) = { frame, is_fd };
         return true;
     }
 
+    // sends queued frames highest priority first until the queues are empty or the socket pushes
+    // back, frames left behind wait for the next POLLOUT or send
+    void Can_interface::flush() {
+        std::unique_lock lock(tx_lock);
+        iovec iov[MAX_BATCH];
+        mmsghdr msgs[MAX_BATCH];
+        TxQueue *owner[MAX_BATCH];
+        while (true) {
+            size_t n = 0;
+            for (auto &queue : tx_queues) {
+                for (size_t i = 0; i < queue.size && n < MAX_BATCH; i++, n++) {
+                    auto &slot = queue.at(i);
+                    iov[n] = { .iov_base = &slot.frame, .iov_len = slot.fd ? CANFD_MTU : CAN_MTU };
+                    msgs[n] = {};
+                    msgs[n].msg_hdr.msg_iov = &iov[n];
+                    msgs[n].msg_hdr.msg_iovlen = 1;
+                    owner[n] = &queue;
+                }
+            }
+            if (n == 0) {
+                tx_backlog.store(false, std::memory_order_release);
+                return;
+            }
+
+            int res = sendmmsg(soket_id, msgs, n, MSG_DONTWAIT);
+            stats_.tx_syscalls.fetch_add(1, std::memory_order_relaxed);
+            if (res < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                    stats_.tx_backlogged.fetch_add(1, std::memory_order_relaxed);
+                    bool nobufs = errno == ENOBUFS;
+                    bool was_nobufs = tx_nobufs.exchange(nobufs, std::memory_order_relaxed);
+                    // a backlog waiting for POLLOUT that hits ENOBUFS needs the retry timer now
+                    if (!tx_backlog.exchange(true, std::memory_order_acq_rel) ||
+                        (nobufs && !was_nobufs)) {
+                        uint64_t one = 1;
+                        write(tx_event, &one, sizeof(one));
+                    }
+                    return;
+                }
+                // the head frame itself is bad (e.g. FD on a classic bus), drop it and go on
+                stats_.tx_failures.fetch_add(1, std::memory_order_relaxed);
+                res = 1;
+            } else {
+                stats_.tx_frames.fetch_add(res, std::memory_order_relaxed);
+                stats_.tx_batch.record(res);
+                if (auto writer = capture.load(std::memory_order_acquire)) {
+                    auto ts = steady_ns(std::chrono::steady_clock::now());
+                    for (int i = 0; i < res; i++) {
+                        auto frame = static_cast<const canfd_frame *>(iov[i].iov_base);
+                        writer->write(ts, *frame, iov[i].iov_len == CANFD_MTU, true);
+                    }
+                }
+            }
+            // frames went out in queue order, so each sent one is at its queue's head
+            for (int i = 0; i < res; i++) {
+                auto &queue = *owner[i];
+                queue.head = (queue.head + 1) % TX_QUEUE_DEPTH;
+                queue.size--;
+            }
+        }
+    }
+
+    bool Can_interface::send(const can_frame &frame, TxPriority priority) {
+        // can_frame is the first CAN_MTU bytes of a zeroed canfd_frame
+        canfd_frame slot{};
+        slot.can_id = frame.can_id;
+        slot.len = std::min<uint8_t>(frame.len, CAN_MAX_DLEN);
+        std::memcpy(slot.data, frame.data, slot.len);
+        bool queued;
+        {
+            std::unique_lock lock(tx_lock);
+            queued = enqueue(slot, false, priority);
+        }
+        flush();
+        return queued;
+    }
+
+    bool Can_interface::send(const canfd_frame &frame, TxPriority priority) {
+        if (!fd_enabled()) {
+            LOG_ERR("CAN error[%s]: FD frame sent before enable_fd\n", name.c_str());
+            return false;
+        }
+        bool queued;
+        {
+            std::unique_lock lock(tx_lock);
+            queued = enqueue(frame, true, priority);
+        }
+        flush();
+        return queued;
+    }
+
+    bool Can_interface::send_batch(const can_frame *frames, size_t num, TxPriority priority) {
+        // queue the whole batch first so that one sendmmsg carries it
+        bool queued = true;
+        {
+            std::unique_lock lock(tx_lock);
+            for (size_t i = 0; i < num; i++) {
+                canfd_frame slot{};
+                slot.can_id = frames[i].can_id;
+                slot.len = std::min<uint8_t>(frames[i].len, CAN_MAX_DLEN);
+                std::memcpy(slot.data, frames[i].data, slot.len);
+                queued &= enqueue(slot, false, priority);
+            }
+        }
+        flush();
+        return queued;
+    }
+
+    const Can_interface::Stats &Can_interface::stats() const {
+        return stats_;
+    }
+
+    Can_interface::time_point Can_interface::rx_stamp() const {
+        return rx_stamp_;
+    }
+
 }  // namespace IO
@@ -0,0 +1,150 @@
+#include "can_trace.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#include "utils.hpp"
+
+namespace IO
+{
+    static int64_t clock_ns(clockid_t clock) {
+        timespec ts;
+        clock_gettime(clock, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    CanTraceWriter::~CanTraceWriter() {
+        close();
+    }
+
+    bool CanTraceWriter::open(const std::string &path, const std::string &interface) {
+        std::unique_lock guard(lock);
+        file = fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            LOG_ERR("CAN trace error: can't open %s\n", path.c_str());
+            return false;
+        }
+        CanTraceHeader header{};
+        std::memcpy(header.magic, CanTraceHeader::MAGIC, sizeof(header.magic));
+        header.version = CanTraceHeader::VERSION;
+        std::strncpy(header.interface, interface.c_str(), IFNAMSIZ - 1);
+        header.realtime_offset_ns = clock_ns(CLOCK_REALTIME) - clock_ns(CLOCK_MONOTONIC);
+        fwrite(&header, sizeof(header), 1, file);
+        return true;
+    }
+
+    void CanTraceWriter::close() {
+        std::unique_lock guard(lock);
+        if (file != nullptr) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    void CanTraceWriter::write(uint64_t ts_ns, const canfd_frame &frame, bool fd, bool tx) {
+        CanTraceRecord record{};
+        record.ts_ns = ts_ns;
+        record.can_id = frame.can_id;
+        record.len = std::min<uint8_t>(frame.len, CANFD_MAX_DLEN);
+        record.flags = (tx ? CanTraceRecord::TX : 0) | (fd ? CanTraceRecord::FD : 0);
+        record.fd_flags = fd ? frame.flags : 0;
+
+        uint8_t data[CANFD_MAX_DLEN] = {};
+        std::memcpy(data, frame.data, record.len);
+
+        std::unique_lock guard(lock);
+        if (file == nullptr) {
+            return;
+        }
+        fwrite(&record, sizeof(record), 1, file);
+        fwrite(data, CanTraceRecord::data_size(record.len), 1, file);
+    }
+
+    void CanTraceWriter::write(uint64_t ts_ns, const can_frame &frame, bool tx) {
+        canfd_frame copy{};
+        copy.can_id = frame.can_id;
+        copy.len = std::min<uint8_t>(frame.len, CAN_MAX_DLEN);
+        std::memcpy(copy.data, frame.data, copy.len);
+        write(ts_ns, copy, false, tx);
+    }
+
+    CanTraceReader::~CanTraceReader() {
+        if (base != nullptr) {
+            munmap(const_cast<uint8_t *>(base), size);
+        }
+    }
+
+    bool CanTraceReader::open(const std::string &path) {
+        if (base != nullptr) {
+            munmap(const_cast<uint8_t *>(base), size);
+            base = nullptr;
+            size = 0;
+        }
+        offset = 0;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG_ERR("CAN trace error: can't open %s\n", path.c_str());
+            return false;
+        }
+        struct stat st{};
+        fstat(fd, &st);
+        size = st.st_size;
+        void *map = size >= sizeof(CanTraceHeader)
+                        ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                        : MAP_FAILED;
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            LOG_ERR("CAN trace error: can't map %s\n", path.c_str());
+            size = 0;
+            return false;
+        }
+        base = static_cast<const uint8_t *>(map);
+        madvise(map, size, MADV_SEQUENTIAL);
+
+        const auto &head = header();
+        if (std::memcmp(head.magic, CanTraceHeader::MAGIC, sizeof(head.magic)) != 0 ||
+            head.version != CanTraceHeader::VERSION) {
+            LOG_ERR("CAN trace error: %s is not a version %u trace\n",
+                    path.c_str(), CanTraceHeader::VERSION);
+            return false;
+        }
+        rewind();
+        return true;
+    }
+
+    const CanTraceHeader &CanTraceReader::header() const {
+        return *reinterpret_cast<const CanTraceHeader *>(base);
+    }
+
+    bool CanTraceReader::next(Frame &out) {
+        if (offset + sizeof(CanTraceRecord) > size) {
+            return false;
+        }
+        CanTraceRecord record;
+        std::memcpy(&record, base + offset, sizeof(record));
+        size_t data_size = CanTraceRecord::data_size(record.len);
+        if (record.len > CANFD_MAX_DLEN || offset + sizeof(record) + data_size > size) {
+            return false;
+        }
+        out.ts_ns = record.ts_ns;
+        out.tx = record.flags & CanTraceRecord::TX;
+        out.fd = record.flags & CanTraceRecord::FD;
+        out.frame = {};
+        out.frame.can_id = record.can_id;
+        out.frame.len = record.len;
+        out.frame.flags = record.fd_flags;
+        std::memcpy(out.frame.data, base + offset + sizeof(record), record.len);
+        offset += sizeof(record) + data_size;
+        return true;
+    }
+
+    void CanTraceReader::rewind() {
+        offset = sizeof(CanTraceHeader);
+    }
+}  // namespace IO
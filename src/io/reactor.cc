@@ -0,0 +1,117 @@
+#include "reactor.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+#include "rt_profile.hpp"
+#include "utils.hpp"
+
+namespace IO
+{
+    Reactor::~Reactor() {
+        for (auto &worker : workers) {
+            worker->handle.detach();
+        }
+    }
+
+    void Reactor::start(int worker_num) {
+        std::unique_lock guard(lock);
+        if (!workers.empty()) {
+            return;
+        }
+        for (int i = 0; i < worker_num; i++) {
+            auto &worker = workers.emplace_back(std::make_unique<Worker>());
+            worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+            if (worker->epoll_fd < 0) {
+                LOG_ERR("Reactor error: can't create epoll instance\n");
+                throw std::runtime_error("Reactor error: can't create epoll instance");
+            }
+            worker->handle = std::thread([this, p = worker.get()]() { run(*p); });
+            UserLib::rt_profile.apply("io", worker->handle.native_handle());
+        }
+        LOG_OK("Reactor start with %d worker(s)\n", worker_num);
+    }
+
+    bool Reactor::running() const {
+        std::unique_lock guard(lock);
+        return !workers.empty();
+    }
+
+    void Reactor::add(const std::string &name, int fd, Handler handler, uint32_t events) {
+        std::unique_lock guard(lock);
+        if (workers.empty()) {
+            LOG_ERR("Reactor error: register %s before start\n", name.c_str());
+            throw std::runtime_error("Reactor error: register " + name + " before start");
+        }
+        auto &source = sources.emplace_back(std::make_unique<Source>());
+        source->name = name;
+        source->fd = fd;
+        source->handler = std::move(handler);
+
+        // devices are spread over the workers round robin
+        auto &worker = workers[next_worker++ % workers.size()];
+        epoll_event ev{};
+        ev.events = events | EPOLLET;
+        ev.data.ptr = source.get();
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            LOG_ERR("Reactor error: can't watch %s (fd %d)\n", name.c_str(), fd);
+            throw std::runtime_error("Reactor error: can't watch " + name);
+        }
+    }
+
+    void Reactor::run(Worker &worker) {
+        constexpr int MAX_EVENTS = 16;
+        epoll_event events[MAX_EVENTS];
+        while (true) {
+            int n = epoll_wait(worker.epoll_fd, events, MAX_EVENTS, -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERR("Reactor error: epoll_wait failed\n");
+                return;
+            }
+            auto wake = std::chrono::steady_clock::now();
+            for (int i = 0; i < n; i++) {
+                auto source = static_cast<Source *>(events[i].data.ptr);
+                source->handler(events[i].events);
+                source->dispatch_latency.record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - wake)
+                        .count());
+            }
+        }
+    }
+
+    void Reactor::diagnostics(const Publish &publish) const {
+        std::unique_lock guard(lock);
+        for (const auto &source : sources) {
+            const auto &h = source->dispatch_latency;
+            if (h.count() == 0) {
+                continue;
+            }
+            publish(source->name + ".dispatch_p50_us", h.percentile(0.5) / 1e3);
+            publish(source->name + ".dispatch_p99_us", h.percentile(0.99) / 1e3);
+            publish(source->name + ".dispatch_max_us", h.max() / 1e3);
+        }
+    }
+
+    void Reactor::report() const {
+        std::unique_lock guard(lock);
+        for (const auto &source : sources) {
+            const auto &h = source->dispatch_latency;
+            LOG_INFO(
+                "reactor %s: %lu dispatch, p50 %.1fus p99 %.1fus max %.1fus\n",
+                source->name.c_str(),
+                h.count(),
+                h.percentile(0.5) / 1e3,
+                h.percentile(0.99) / 1e3,
+                h.max() / 1e3);
+        }
+    }
+}  // namespace IO
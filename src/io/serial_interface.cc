@@ -1,12 +1,27 @@
 #include "serial_interface.hpp"
 
-#include "user_lib.hpp"
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#include "serial_tuning.hpp"
+
 
 namespace IO
 {
-    Serial_interface::Serial_interface(std::string port_name, int baudrate, int simple_timeout)
+    Serial_interface::Serial_interface(
+        std::string port_name, int baudrate, int simple_timeout, bool low_latency)
         : serial::Serial(port_name, baudrate, serial::Timeout::simpleTimeout(simple_timeout)),
           name(port_name) {
+        std::fill(std::begin(next_seq), std::end(next_seq), -1);
+        if (low_latency) {
+            tune_low_latency(baudrate);
+        }
     }
 
     Serial_interface::~Serial_interface() = default;
@@ -21,27 +36,218 @@ namespace IO
         }
     }
 
-    inline int Serial_interface::unpack(uint8_t pkg_id) {
+    inline void Serial_interface::unpack(uint8_t pkg_id, const uint8_t *payload) {
+        rx_stamp_ = first_seen();
         if (pkg_id == 1) {
-            memcpy(buffer, read(sizeof(Types::ReceivePacket_IMU)).c_str(), sizeof(Types::ReceivePacket_IMU));
-            UserLib::fromVector(buffer, &imu_pkg);
+            std::memcpy(&imu_pkg, payload, sizeof(Types::ReceivePacket_IMU));
+            stats_.imu_frames.fetch_add(1, std::memory_order_relaxed);
             callback(imu_pkg);
         } else if (pkg_id == 2) {
-            memcpy(buffer, read(sizeof(Types::ReceivePacket_RC_CTRL)).c_str(), sizeof(Types::ReceivePacket_RC_CTRL));
-            UserLib::fromVector(buffer, &rc_pkg);
+            std::memcpy(&rc_pkg, payload, sizeof(Types::ReceivePacket_RC_CTRL));
+            stats_.rc_frames.fetch_add(1, std::memory_order_relaxed);
             callback(rc_pkg);
         }
-        return 0;
+        stats_.rx_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - rx_stamp_)
+                                     .count());
+    }
+
+    std::chrono::steady_clock::time_point Serial_interface::first_seen() const {
+        uint64_t offset = rx_total - (rx_end - rx_begin);
+        uint64_t oldest = read_count > READ_STAMPS ? read_count - READ_STAMPS : 0;
+        for (uint64_t i = oldest; i < read_count; i++) {
+            const auto &stamp = read_stamps[i % READ_STAMPS];
+            if (stamp.end > offset) {
+                return stamp.time;
+            }
+        }
+        return read_stamps[(read_count - 1) % READ_STAMPS].time;
+    }
+
+    void Serial_interface::tune_low_latency(int baudrate) {
+        int port_fd = native_handle();
+        if (port_fd < 0) {
+            LOG_ERR("serial error: %s has no descriptor, low latency mode skipped\n", name.c_str());
+            return;
+        }
+        if (!SerialTuning::set_low_latency(port_fd)) {
+            // CDC-ACM and PTYs have no TIOCSSERIAL, the rest still helps
+            LOG_INFO("serial %s: ASYNC_LOW_LATENCY not supported\n", name.c_str());
+        }
+        if (!SerialTuning::set_baudrate(port_fd, baudrate)) {
+            LOG_ERR("serial error: can't set %s to %d baud\n", name.c_str(), baudrate);
+        }
+        SerialTuning::flush_input(port_fd);
+        LOG_OK("serial %s: low latency mode\n", name.c_str());
+    }
+
+    // only asked for by IO::insert when a reactor serves the port, threaded reads stay on
+    // serial::Serial::read
+    int Serial_interface::fd() const {
+        if (native_fd < 0) {
+            native_fd = native_handle();
+        }
+        return native_fd;
+    }
+
+    ssize_t Serial_interface::read_chunk() {
+        // parse() leaves at most one partial frame, move it to the front as soon as the tail has
+        // no room for a whole frame, otherwise reads shrink to the few bytes left at the end
+        if (rx_begin > 0 && RX_BUFFER_SIZE - rx_end < SerialProtocol::MAX_FRAME) {
+            std::memmove(rx_buffer, rx_buffer + rx_begin, rx_end - rx_begin);
+            rx_end -= rx_begin;
+            rx_begin = 0;
+        }
+        size_t space = RX_BUFFER_SIZE - rx_end;
+        ssize_t n;
+        if (native_fd >= 0) {
+            n = ::read(native_fd, rx_buffer + rx_end, space);
+        } else {
+            size_t ready = std::min(available(), space);
+            if (ready == 0) {
+                errno = EAGAIN;
+                n = -1;
+            } else {
+                n = static_cast<ssize_t>(read(rx_buffer + rx_end, ready));
+            }
+        }
+        stats_.rx_syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (n > 0) {
+            rx_end += n;
+            rx_total += n;
+            read_stamps[read_count++ % READ_STAMPS] = {
+                rx_total, std::chrono::steady_clock::now() };
+            stats_.rx_bytes.fetch_add(n, std::memory_order_relaxed);
+            stats_.read_bytes.record(n);
+        }
+        return n;
+    }
+
+    void Serial_interface::skip(size_t n) {
+        rx_begin += n;
+        stats_.resync_bytes.fetch_add(n, std::memory_order_relaxed);
+        if (in_sync) {
+            in_sync = false;
+            stats_.resyncs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Serial_interface::check_seq(uint8_t pkg_id, uint8_t seq) {
+        if (next_seq[pkg_id] >= 0) {
+            uint8_t missing = seq - static_cast<uint8_t>(next_seq[pkg_id]);
+            if (missing != 0) {
+                stats_.seq_gaps.fetch_add(missing, std::memory_order_relaxed);
+            }
+        }
+        next_seq[pkg_id] = static_cast<uint8_t>(seq + 1);
+    }
+
+    void Serial_interface::parse() {
+        using namespace SerialProtocol;
+        bool accept_legacy = framing_ == Framing::LEGACY || (framing_ == Framing::AUTO && !v2_seen);
+        bool accept_v2 = framing_ != Framing::LEGACY;
+        while (rx_end - rx_begin >= 2) {
+            const uint8_t *p = rx_buffer + rx_begin;
+            size_t avail = rx_end - rx_begin;
+
+            if (accept_v2 && p[0] == V2_SOF0 && p[1] == V2_SOF1) {
+                if (avail < V2_HEAD) {
+                    break;
+                }
+                size_t len = payload_size(p[3]);
+                if (p[2] != V2_VERSION || len == 0 || p[4] != len) {
+                    skip(1);
+                    continue;
+                }
+                if (avail < V2_HEAD + len + V2_TAIL) {
+                    break;
+                }
+                uint16_t crc = Referee::crc16(p, V2_HEAD + len);
+                if (p[V2_HEAD + len] != (crc & 0xff) || p[V2_HEAD + len + 1] != (crc >> 8)) {
+                    // 逐字节重新同步: 坏帧里可能藏着下一帧的帧头
+                    stats_.crc_failures.fetch_add(1, std::memory_order_relaxed);
+                    skip(1);
+                    continue;
+                }
+                check_seq(p[3], p[5]);
+                unpack(p[3], p + V2_HEAD);
+                rx_begin += V2_HEAD + len + V2_TAIL;
+                in_sync = true;
+                if (!v2_seen) {
+                    v2_seen = true;
+                    accept_legacy = framing_ == Framing::LEGACY;
+                }
+                continue;
+            }
+
+            if (accept_legacy && p[0] == LEGACY_SOF0 && p[1] == LEGACY_SOF1) {
+                if (avail < LEGACY_HEAD) {
+                    break;
+                }
+                size_t len = payload_size(p[2]);
+                if (len == 0) {
+                    skip(1);
+                    continue;
+                }
+                if (avail < LEGACY_HEAD + len) {
+                    break;
+                }
+                unpack(p[2], p + LEGACY_HEAD);
+                rx_begin += LEGACY_HEAD + len;
+                in_sync = true;
+                continue;
+            }
+
+            // hunt for the next byte that can start a frame we accept
+            size_t next = 1;
+            while (next < avail && !(accept_v2 && p[next] == V2_SOF0) &&
+                   !(accept_legacy && p[next] == LEGACY_SOF0)) {
+                next++;
+            }
+            skip(next);
+        }
+        if (rx_begin == rx_end) {
+            rx_begin = rx_end = 0;
+        }
+    }
+
+    void Serial_interface::on_ready(uint32_t events) {
+        // edge triggered: read until the driver has nothing left, frames split across reads
+        // stay in rx_buffer until the rest arrives. serial::Serial leaves VMIN=0, so an empty
+        // tty reads 0 instead of EAGAIN, only a hang-up means the device went away
+        bool hangup = events & (EPOLLHUP | EPOLLERR);
+        try {
+            while (isOpen()) {
+                ssize_t n = read_chunk();
+                if (n > 0) {
+                    parse();
+                } else if (!hangup && (n == 0 || errno == EAGAIN)) {
+                    return;
+                } else {
+                    LOG_ERR("serail offline! end program now\n");
+                    exit(-1);
+                }
+            }
+        } catch (serial::IOException &e) {
+            LOG_ERR("serail offline! end program now\n");
+            exit(-1);
+        }
     }
 
     void Serial_interface::task() {
         while (true) {
             try {
                 if (isOpen()) {
-                    read((uint8_t *)&header, 2);
-                    if (header == 0xAA55) {
-                        read((uint8_t *)&header, 1);
-                        unpack(header);
+                    if (!waitReadable()) {
+                        continue;
+                    }
+                    ssize_t n = read_chunk();
+                    if (n > 0) {
+                        parse();
+                    } else if (n == 0 || errno != EAGAIN) {
+                        // readable but nothing to read: the device went away
+                        LOG_ERR("serail offline! end program now\n");
+                        exit(-1);
                     }
                 } else {
                     enumerate_ports();
@@ -53,4 +259,53 @@ namespace IO
             }
         }
     }
+
+    const Serial_interface::Stats &Serial_interface::stats() const {
+        return stats_;
+    }
+
+    std::chrono::steady_clock::time_point Serial_interface::rx_stamp() const {
+        return rx_stamp_;
+    }
+
+    void Serial_interface::set_framing(Framing mode) {
+        framing_ = mode;
+        v2_seen = false;
+    }
+
+    Serial_interface::Framing Serial_interface::framing() const {
+        return framing_;
+    }
+
+    void Serial_interface::diagnostics(const Publish &publish) {
+        Window now;
+        now.time = std::chrono::steady_clock::now();
+        now.rx_syscalls = stats_.rx_syscalls.load(std::memory_order_relaxed);
+        now.rx_bytes = stats_.rx_bytes.load(std::memory_order_relaxed);
+        now.imu_frames = stats_.imu_frames.load(std::memory_order_relaxed);
+        now.rc_frames = stats_.rc_frames.load(std::memory_order_relaxed);
+        now.resync_bytes = stats_.resync_bytes.load(std::memory_order_relaxed);
+        now.resyncs = stats_.resyncs.load(std::memory_order_relaxed);
+        now.crc_failures = stats_.crc_failures.load(std::memory_order_relaxed);
+        now.seq_gaps = stats_.seq_gaps.load(std::memory_order_relaxed);
+        double dt = std::chrono::duration<double>(now.time - last_window.time).count();
+        if (last_window.time.time_since_epoch().count() != 0 && dt > 0) {
+            uint64_t reads = now.rx_syscalls - last_window.rx_syscalls;
+            uint64_t frames = now.imu_frames + now.rc_frames - last_window.imu_frames -
+                              last_window.rc_frames;
+            publish(
+                "bytes_per_read",
+                reads ? static_cast<double>(now.rx_bytes - last_window.rx_bytes) / reads : 0.);
+            publish("fps", frames / dt);
+            publish("imu_fps", (now.imu_frames - last_window.imu_frames) / dt);
+            publish("rc_fps", (now.rc_frames - last_window.rc_frames) / dt);
+            publish("resync_bytes", now.resync_bytes - last_window.resync_bytes);
+            publish("resyncs", now.resyncs - last_window.resyncs);
+            publish("crc_fail", now.crc_failures - last_window.crc_failures);
+            publish("seq_gaps", now.seq_gaps - last_window.seq_gaps);
+            publish("latency_p50_us", stats_.rx_latency.percentile(0.5) / 1e3);
+            publish("latency_p99_us", stats_.rx_latency.percentile(0.99) / 1e3);
+        }
+        last_window = now;
+    }
 }  // namespace IO
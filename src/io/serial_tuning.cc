@@ -0,0 +1,34 @@
+#include "serial_tuning.hpp"
+
+// termios2 lives in the kernel headers, keep <termios.h> out of this file
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+
+namespace IO::SerialTuning
+{
+    bool set_low_latency(int fd) {
+        serial_struct serial{};
+        if (ioctl(fd, TIOCGSERIAL, &serial) < 0) {
+            return false;
+        }
+        serial.flags |= ASYNC_LOW_LATENCY;
+        return ioctl(fd, TIOCSSERIAL, &serial) == 0;
+    }
+
+    bool set_baudrate(int fd, int baudrate) {
+        termios2 tio{};
+        if (ioctl(fd, TCGETS2, &tio) < 0) {
+            return false;
+        }
+        tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+        tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+        tio.c_ispeed = baudrate;
+        tio.c_ospeed = baudrate;
+        return ioctl(fd, TCSETS2, &tio) == 0;
+    }
+
+    bool flush_input(int fd) {
+        return ioctl(fd, TCFLSH, TCIFLUSH) == 0;
+    }
+}  // namespace IO::SerialTuning
@@ -0,0 +1,130 @@
+#include "shm_link.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+
+#include "utils.hpp"
+
+namespace IO
+{
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+    bool ShmRing::push(const void *data, uint32_t len) {
+        if (len > SLOT_SIZE) {
+            return false;
+        }
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == SLOTS) {
+            return false;
+        }
+        auto &slot = slots[head % SLOTS];
+        slot.len = len;
+        std::memcpy(slot.data, data, len);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // not FUTEX_PRIVATE_FLAG: the word is mapped by two processes
+    void ShmDoorbell::ring() {
+        seq.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            syscall(SYS_futex, &seq, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+    }
+
+    void ShmDoorbell::wait(uint32_t seen, std::chrono::microseconds timeout) {
+        timespec ts{ static_cast<time_t>(timeout.count() / 1000000),
+                     static_cast<long>(timeout.count() % 1000000 * 1000) };
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        syscall(SYS_futex, &seq, FUTEX_WAIT, seen, &ts, nullptr, 0);
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    ShmLink::~ShmLink() {
+        if (segment != nullptr) {
+            munmap(segment, sizeof(ShmSegment));
+        }
+    }
+
+    bool ShmLink::open(const std::string &name, Side side_) {
+        side = side_;
+        int flags = side == Side::ROBOT ? O_RDWR | O_CREAT : O_RDWR;
+        int fd = shm_open(name.c_str(), flags, 0666);
+        if (fd < 0) {
+            LOG_ERR("shm error: can't open %s\n", name.c_str());
+            return false;
+        }
+        if (side == Side::ROBOT && ftruncate(fd, sizeof(ShmSegment)) < 0) {
+            LOG_ERR("shm error: can't resize %s\n", name.c_str());
+            close(fd);
+            return false;
+        }
+        void *map = mmap(nullptr, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            LOG_ERR("shm error: can't map %s\n", name.c_str());
+            return false;
+        }
+        segment = static_cast<ShmSegment *>(map);
+
+        if (side == Side::ROBOT) {
+            // a restarted robot starts from empty rings, the peer keeps its mapping
+            std::memset(static_cast<void *>(segment), 0, sizeof(ShmSegment));
+            std::memcpy(segment->magic, ShmSegment::MAGIC, sizeof(segment->magic));
+            segment->version = ShmSegment::VERSION;
+        } else if (
+            std::memcmp(segment->magic, ShmSegment::MAGIC, sizeof(segment->magic)) != 0 ||
+            segment->version != ShmSegment::VERSION) {
+            LOG_ERR(
+                "shm error: %s is not a version %u segment\n", name.c_str(), ShmSegment::VERSION);
+            munmap(segment, sizeof(ShmSegment));
+            segment = nullptr;
+            return false;
+        }
+        rx_seen = rx_bell().seq.load(std::memory_order_acquire);
+        return true;
+    }
+
+    ShmRing *ShmLink::tx_ring(uint8_t header) {
+        uint32_t owner = header + 1u;
+        for (auto &channel : segment->channels) {
+            uint32_t current = channel.owner.load(std::memory_order_acquire);
+            if (current == 0 &&
+                channel.owner.compare_exchange_strong(current, owner, std::memory_order_acq_rel)) {
+                current = owner;
+            }
+            if (current == owner) {
+                return side == Side::ROBOT ? &channel.to_vision : &channel.to_robot;
+            }
+        }
+        LOG_ERR("shm error: no free channel for header 0x%x\n", header);
+        return nullptr;
+    }
+
+    bool ShmLink::send(ShmRing *ring, const void *data, uint32_t len) {
+        if (!ring->push(data, len)) {
+            return false;
+        }
+        tx_bell().ring();
+        return true;
+    }
+
+    void ShmLink::wait(std::chrono::microseconds timeout) {
+        auto &bell = rx_bell();
+        bell.wait(rx_seen, timeout);
+        rx_seen = bell.seq.load(std::memory_order_acquire);
+    }
+
+    ShmDoorbell &ShmLink::rx_bell() {
+        return side == Side::ROBOT ? segment->robot_bell : segment->vision_bell;
+    }
+
+    ShmDoorbell &ShmLink::tx_bell() {
+        return side == Side::ROBOT ? segment->vision_bell : segment->robot_bell;
+    }
+}  // namespace IO
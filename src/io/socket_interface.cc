@@ -3,6 +3,10 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
 #include "robot.hpp"
 #include "user_lib.hpp"
 
@@ -10,36 +14,113 @@ namespace IO
 {
     void Server_socket_interface::task() {
         while (true) {
-            memset(buffer, 0, sizeof(buffer));
-            sockaddr_in cli_addr;
-            socklen_t cli_addr_len = sizeof(cli_addr);
-            auto n =
-                recvfrom(sockfd, buffer, 256, MSG_WAITALL, (sockaddr *)&cli_addr, &cli_addr_len);
-            if (n > 0) {
-                uint8_t header = buffer[0];
-                if (clients.count(header) == 0) {
-                    LOG_OK("register clients %d\n", header);
-                    clients.insert(std::pair<uint8_t, sockaddr_in>(header, cli_addr));
-                }
-                switch (header) {
-                    case 0x37: {
-                        Robot::ReceiveNavigationInfo pkg{};
-                        UserLib::unpack(pkg, buffer);
-                        callback(pkg);
-                        break;
-                    }
-                    default: {
-                        Robot::Auto_aim_control vc;
-                        UserLib::unpack(vc, buffer);
-                        callback_key(vc.header, vc);
-                        break;
-                    }
+            // blocks for the first datagram, then takes whatever else is queued
+            receive(MSG_WAITFORONE);
+        }
+    }
+
+    int Server_socket_interface::fd() const {
+        return sockfd;
+    }
+
+    void Server_socket_interface::on_ready([[maybe_unused]] uint32_t events) {
+        while (receive(MSG_DONTWAIT) > 0) {
+        }
+    }
+
+    int Server_socket_interface::receive(int flags) {
+        for (size_t i = 0; i < MAX_BATCH; i++) {
+            rx_msgs[i].msg_hdr.msg_namelen = sizeof(rx_names[i]);
+        }
+        int n = recvmmsg(sockfd, rx_msgs, MAX_BATCH, flags, nullptr);
+        if (n <= 0) {
+            return n;
+        }
+        stats_.rx_batch.record(n);
+        stats_.rx_packets.fetch_add(n, std::memory_order_relaxed);
+        for (int i = 0; i < n; i++) {
+            dispatch(rx_buffers[i], rx_msgs[i].msg_len, &rx_names[i]);
+        }
+        return n;
+    }
+
+    // no memset of the buffer: packets shorter than their struct get zeros through pkg{}
+    void Server_socket_interface::dispatch(
+        const uint8_t *data, size_t len, const sockaddr_in *from) {
+        if (len == 0) {
+            return;
+        }
+        std::unique_lock guard(dispatch_lock);
+        uint8_t header = data[0];
+        if (from != nullptr && !clients[header].valid.load(std::memory_order_acquire)) {
+            register_client(header, *from);
+        }
+        switch (header) {
+            case 0x37: {
+                Robot::ReceiveNavigationInfo pkg{};
+                std::memcpy(&pkg, data, std::min(len, sizeof(pkg)));
+                callback(pkg);
+                break;
+            }
+            default: {
+                Robot::Auto_aim_control vc{};
+                std::memcpy(&vc, data, std::min(len, sizeof(vc)));
+                if (vc.seq != 0 && !check_command(vc, from)) {
+                    break;
                 }
+                callback_key(vc.header, vc);
+                break;
             }
         }
     }
 
-    Server_socket_interface::Server_socket_interface(std::string name)
+    bool Server_socket_interface::check_command(
+        const Robot::Auto_aim_control &vc, const sockaddr_in *from) {
+        uint64_t now = UserLib::steady_ns();
+        // echo_ns is one of our own stamps, valid whatever host the peer is on
+        if (vc.echo_ns != 0 && vc.echo_ns <= now) {
+            stats_.aim_rtt.record(now - vc.echo_ns);
+        }
+        // sent_ns only shares our clock when the peer runs on this host
+        bool same_clock = from == nullptr || (ntohl(from->sin_addr.s_addr) >> 24) == 127;
+        if (!same_clock || vc.sent_ns == 0 || vc.sent_ns > now) {
+            return true;
+        }
+        uint64_t age = now - vc.sent_ns;
+        stats_.aim_one_way.record(age);
+        uint64_t max_age = max_command_age_ns.load(std::memory_order_relaxed);
+        if (max_age != 0 && age > max_age) {
+            stats_.aim_stale.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void Server_socket_interface::shm_task() {
+        while (true) {
+            size_t n = shm->poll([this](const uint8_t *data, uint32_t len) {
+                dispatch(data, len, nullptr);
+            });
+            if (n > 0) {
+                stats_.rx_packets.fetch_add(n, std::memory_order_relaxed);
+            } else {
+                shm->wait(std::chrono::milliseconds(100));
+            }
+        }
+    }
+
+    void Server_socket_interface::register_client(uint8_t header, const sockaddr_in &addr) {
+        std::unique_lock guard(register_lock);
+        auto &target = clients[header];
+        if (target.valid.load(std::memory_order_relaxed)) {
+            return;
+        }
+        LOG_OK("register clients %d\n", header);
+        target.addr = addr;
+        target.valid.store(true, std::memory_order_release);
+    }
+
+    Server_socket_interface::Server_socket_interface(std::string name, bool shm_)
         : port_num(11451),
           name(name) {
         // NOTE: read this https://www.linuxhowtos.org/C_C++/socket.htm
@@ -55,15 +136,139 @@ namespace IO
         if (bind(sockfd, (sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
             LOG_ERR("can't bind socket fd with port number");
         }
+
+        for (size_t i = 0; i < MAX_BATCH; i++) {
+            rx_iov[i] = { rx_buffers[i], MAX_DATAGRAM };
+            rx_msgs[i].msg_hdr = {};
+            rx_msgs[i].msg_hdr.msg_name = &rx_names[i];
+            rx_msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+            rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        if (shm_) {
+            shm = std::make_unique<ShmLink>();
+            if (shm->open("/gkd_" + name, ShmLink::Side::ROBOT)) {
+                std::thread([this] { shm_task(); }).detach();
+                LOG_OK("socket %s: shared memory /gkd_%s\n", name.c_str(), name.c_str());
+            } else {
+                shm.reset();
+            }
+        }
     }
 
-    void Server_socket_interface::add_client(uint8_t header, std::string ip, int port) {
-        sockaddr_in client;
+    Server_socket_interface::Client Server_socket_interface::add_client(
+        uint8_t header, std::string ip, int port) {
+        sockaddr_in client{};
         client.sin_family = AF_INET;
         client.sin_addr.s_addr = inet_addr(ip.c_str());
         client.sin_port = htons(port);
-        clients.insert(std::pair<uint8_t, sockaddr_in>(header, client));
+        register_client(header, client);
         // LOG_INFO("ip %s, port %d\n", ip.c_str(), port);
+        return Client(&clients[header].addr, shm ? shm->tx_ring(header) : nullptr);
+    }
+
+    Server_socket_interface::Client Server_socket_interface::client(uint8_t header) const {
+        const auto &target = clients[header];
+        if (!target.valid.load(std::memory_order_acquire)) {
+            return Client();
+        }
+        return Client(&target.addr, shm ? shm->tx_ring(header) : nullptr);
+    }
+
+    void Server_socket_interface::send_raw(Client target, const void *data, size_t len) {
+        if (target.ring != nullptr) {
+            // no syscall unless the peer is asleep on its doorbell
+            if (shm->send(target.ring, data, len)) {
+                stats_.tx_packets.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                stats_.tx_failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        auto n = sendto(
+            sockfd,
+            data,
+            len,
+            MSG_CONFIRM | MSG_DONTWAIT,
+            reinterpret_cast<const sockaddr *>(target.addr),
+            sizeof(sockaddr_in));
+        if (n < 0) {
+            stats_.tx_failures.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            stats_.tx_packets.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Server_socket_interface::fan_out_raw(
+        std::span<const Client> targets, const void *data, size_t len) {
+        mmsghdr msgs[MAX_BATCH];
+        iovec iov{ const_cast<void *>(data), len };
+        size_t count = 0;
+        auto flush = [&]() {
+            if (count == 0) {
+                return;
+            }
+            int sent = sendmmsg(sockfd, msgs, count, MSG_CONFIRM | MSG_DONTWAIT);
+            size_t ok = sent > 0 ? sent : 0;
+            stats_.tx_packets.fetch_add(ok, std::memory_order_relaxed);
+            stats_.tx_failures.fetch_add(count - ok, std::memory_order_relaxed);
+            count = 0;
+        };
+        for (auto target : targets) {
+            if (!target) {
+                stats_.tx_unknown.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (target.ring != nullptr) {
+                send_raw(target, data, len);
+                continue;
+            }
+            msgs[count].msg_hdr = {};
+            msgs[count].msg_hdr.msg_name = const_cast<sockaddr_in *>(target.addr);
+            msgs[count].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            msgs[count].msg_hdr.msg_iov = &iov;
+            msgs[count].msg_hdr.msg_iovlen = 1;
+            if (++count == MAX_BATCH) {
+                flush();
+            }
+        }
+        flush();
+    }
+
+    const Server_socket_interface::Stats &Server_socket_interface::stats() const {
+        return stats_;
+    }
+
+    void Server_socket_interface::set_max_command_age(std::chrono::nanoseconds age) {
+        max_command_age_ns.store(age.count(), std::memory_order_relaxed);
+    }
+
+    void Server_socket_interface::diagnostics(const Publish &publish) {
+        Window now;
+        now.time = std::chrono::steady_clock::now();
+        now.rx_packets = stats_.rx_packets.load(std::memory_order_relaxed);
+        now.tx_packets = stats_.tx_packets.load(std::memory_order_relaxed);
+        now.tx_failures = stats_.tx_failures.load(std::memory_order_relaxed);
+        now.tx_unknown = stats_.tx_unknown.load(std::memory_order_relaxed);
+        now.aim_stale = stats_.aim_stale.load(std::memory_order_relaxed);
+        double dt = std::chrono::duration<double>(now.time - last_window.time).count();
+        if (last_window.time.time_since_epoch().count() != 0 && dt > 0) {
+            publish("rx_pps", (now.rx_packets - last_window.rx_packets) / dt);
+            publish("tx_pps", (now.tx_packets - last_window.tx_packets) / dt);
+            publish("tx_fail", now.tx_failures - last_window.tx_failures);
+            publish("tx_unknown", now.tx_unknown - last_window.tx_unknown);
+            publish("aim_stale", now.aim_stale - last_window.aim_stale);
+        }
+        auto latency = [&](const std::string &key, const UserLib::Histogram &hist) {
+            if (hist.count() == 0) {
+                return;
+            }
+            publish(key + "_p50_us", hist.percentile(0.5) / 1e3);
+            publish(key + "_p99_us", hist.percentile(0.99) / 1e3);
+        };
+        latency("aim_one_way", stats_.aim_one_way);
+        latency("aim_rtt", stats_.aim_rtt);
+        last_window = now;
     }
 
     Server_socket_interface::~Server_socket_interface() {
@@ -1,12 +1,55 @@
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
 #include <user_lib.hpp>
+#include "can_trace.hpp"
+#include "io.hpp"
 #include "robot_controller.hpp"
+#include "rt_profile.hpp"
 #include "utils.hpp"
 
+// --can-replay <trace> [--replay-fast]: feed a .gkdtrace back into its interface's callbacks,
+// no interface is read meanwhile; the process exits through exit_task once the trace ends
+static void can_replay(const char *path, bool paced) {
+    IO::CanTraceReader trace;
+    auto can = trace.open(path) ? IO::io<CAN>[trace.header().interface] : nullptr;
+    if (can == nullptr) {
+        kill(getpid(), SIGTERM);
+        return;
+    }
+    auto result = can->replay(trace, paced);
+    LOG_INFO(
+        "replay %s: %lu frames (%lu delivered) in %.3fs, %.0f frames/s\n",
+        path,
+        result.frames,
+        result.delivered,
+        result.seconds,
+        result.frames / result.seconds);
+    kill(getpid(), SIGTERM);
+}
+
 int main(int argc, char **argv) {
+    const char *replay_path = nullptr;
+    bool replay_paced = true;
+    const char *rt_name = getenv("GKD_RT_PROFILE");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--can-replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-fast") == 0) {
+            replay_paced = false;
+        } else if (strcmp(argv[i], "--rt-profile") == 0 && i + 1 < argc) {
+            rt_name = argv[++i];
+        }
+    }
+    // before any thread exists: mlockall and the main stack, every thread applies its entry
+    if (rt_name != nullptr && !UserLib::rt_profile.select(Config::RtProfiles, rt_name)) {
+        return -1;
+    }
+
     Robot::Robot_ctrl robot;
 
-    robot.load_hardware();
+    robot.load_hardware(replay_path != nullptr);
 
     robot.start_init();
     robot.init_join();
@@ -15,6 +58,9 @@ int main(int argc, char **argv) {
     robot.robot_set->set_mode(Types::ROBOT_MODE::ROBOT_FOLLOW_GIMBAL);
 
     robot.start();
+    if (replay_path != nullptr) {
+        std::thread(can_replay, replay_path, replay_paced).detach();
+    }
     robot.join();
 
     return 0;
@@ -1,14 +1,21 @@
 #include "robot_controller.hpp"
 
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+
 #include "io.hpp"
 #include "logger.hpp"
 #include "macro_helpers.hpp"
 #include "referee.hpp"
 #include "robot_type_config.hpp"
+#include "rt_profile.hpp"
+#include "topic.hpp"
 
 namespace Robot
 {
-
     Robot_ctrl::Robot_ctrl()
         : rc_controller(Config::rc_controller_serial),
           gimbal(Config::gimbal_config),
@@ -17,6 +24,16 @@ namespace Robot
             ,
             gimbal_sentry(Config::gimbal_config)) {
         robot_set = std::make_shared<Robot_set>();
+        executor.set_budget(Config::LOOP_BUDGET_PERCENT);
+
+        // blocked before the first thread starts so every thread inherits the mask and
+        // SIGINT/SIGTERM only reach exit_task
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGINT);
+        sigaddset(&set, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+        std::thread(&Robot_ctrl::exit_task, this, set).detach();
     }
 
     Robot_ctrl::~Robot_ctrl() = default;
@@ -35,8 +52,18 @@ namespace Robot
         gimbal.init(robot_set);
         IFDEF(CONFIG_SENTRY, gimbal_sentry.init(robot_set));
 
-        // start DJIMotorManager thread
-        Hardware::DJIMotorManager::start();
+        if (replay_mode) {
+            // nothing comes online before the trace plays, skip the gimbal homing
+            robot_set->inited = Types::Init_status::INIT_FINISH;
+            return;
+        }
+
+        // motor TX runs from init on, init_task needs the motors driven
+        executor.add(
+            "motor_tx",
+            std::chrono::milliseconds(1),
+            std::chrono::microseconds(Config::MOTOR_TX_PHASE_US),
+            Hardware::DJIMotorManager::tick);
 
         threads.emplace_back(&Config::GimbalType::init_task, &gimbal);
         IFDEF(CONFIG_SENTRY, threads.emplace_back(&Gimbal::GimbalT::init_task, &gimbal_sentry));
@@ -47,12 +74,183 @@ namespace Robot
     }
 
     void Robot_ctrl::start() {
-        threads.emplace_back(&Config::GimbalType::task, &gimbal);
-        threads.emplace_back(&Chassis::Chassis::task, &chassis);
+        if (Config::CONTROL_PIPELINE) {
+            start_pipeline();
+        } else {
+            start_loops();
+        }
         threads.emplace_back(&Device::Dji_referee::task, &referee);
+        UserLib::rt_profile.apply("referee", threads.back().native_handle());
         threads.emplace_back(&Device::Dji_referee::task_ui, &referee);
-        IFDEF(CONFIG_SENTRY, threads.emplace_back(&Gimbal::GimbalT::task, &gimbal_sentry));
-        IFDEF(__DEBUG__, threads.emplace_back(&Logger::task, &logger));
+        UserLib::rt_profile.apply("ui", threads.back().native_handle());
+#ifdef __DEBUG__
+        threads.emplace_back(&Logger::task, &logger);
+        UserLib::rt_profile.apply("logger", threads.back().native_handle());
+        threads.emplace_back(&Robot_ctrl::io_diagnostics_task, this);
+        UserLib::rt_profile.apply("io_diag", threads.back().native_handle());
+#endif
+        UserLib::rt_profile.report();
+    }
+
+    void Robot_ctrl::start_loops() {
+        using std::chrono::milliseconds;
+        using Overrun = UserLib::PeriodicExecutor::Overrun;
+        // controllers wake at phase 0, motor_tx sends their give_current later in the same period
+        executor.add(
+            "gimbal",
+            milliseconds(Config::gimbal_config.ControlTime),
+            {},
+            [this] { gimbal.tick(); });
+        executor.add(
+            "chassis",
+            milliseconds(Config::chassis_config.ControlTime),
+            {},
+            [this] { chassis.tick(); });
+        executor.add("power", milliseconds(1), {}, [this] { chassis.power_tick(); });
+        // the friction ramp integrates a fixed dt per tick, so missed ticks are made up
+        IFNDEF(
+            CONFIG_SENTRY,
+            executor.add(
+                "shoot",
+                milliseconds(Config::SHOOT_CONTROL_TIME),
+                {},
+                [this] { gimbal.shoot.tick(); },
+                Overrun::CATCH_UP));
+        IFDEF(
+            CONFIG_SENTRY,
+            executor.add(
+                "gimbal_sentry",
+                milliseconds(Config::gimbal_config.ControlTime),
+                {},
+                [this] { gimbal_sentry.tick(); });
+            executor.add(
+                "shoot",
+                milliseconds(Config::SHOOT_CONTROL_TIME),
+                {},
+                [this] { gimbal_sentry.shoot.tick(); },
+                Overrun::CATCH_UP));
+    }
+
+    void Robot_ctrl::start_pipeline() {
+        const uint32_t period = Config::gimbal_config.ControlTime;
+        auto every = [&](uint32_t ms) { return std::max(1u, ms / period); };
+        // gimbals first: chassis follows their relative yaw
+        pipeline_stages.emplace_back(1, [this] { gimbal.tick(); });
+        IFNDEF(
+            CONFIG_SENTRY,
+            pipeline_stages.emplace_back(
+                every(Config::SHOOT_CONTROL_TIME), [this] { gimbal.shoot.tick(); }));
+        IFDEF(
+            CONFIG_SENTRY,
+            pipeline_stages.emplace_back(1, [this] { gimbal_sentry.tick(); });
+            pipeline_stages.emplace_back(
+                every(Config::SHOOT_CONTROL_TIME), [this] { gimbal_sentry.shoot.tick(); }));
+        pipeline_stages.emplace_back(
+            every(Config::chassis_config.ControlTime), [this] { chassis.tick(); });
+        pipeline_stages.emplace_back(every(1), [this] { chassis.power_tick(); });
+
+        // motor TX moves into the pipeline's actuate stage
+        executor.stop("motor_tx");
+        pipeline_last_tx = std::chrono::steady_clock::now();
+        executor.add(
+            "control", std::chrono::milliseconds(period), {}, [this] { pipeline_tick(); });
+    }
+
+    void Robot_ctrl::pipeline_tick() {
+        auto ns = [](std::chrono::steady_clock::duration d) {
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        };
+        // sense: every online motor has reported since the previous command
+        auto start = std::chrono::steady_clock::now();
+        bool fresh = Hardware::DJIMotorManager::wait_feedback(
+            pipeline_last_tx, std::chrono::microseconds(Config::PIPELINE_RX_TIMEOUT_US));
+        pipeline.rx_wait.record(ns(std::chrono::steady_clock::now() - start));
+        if (!fresh) {
+            pipeline.rx_timeouts.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto oldest = Hardware::DJIMotorManager::oldest_feedback();
+
+        // compute
+        for (auto& [every, tick] : pipeline_stages) {
+            if (pipeline_ticks % every == 0) {
+                tick();
+            }
+        }
+        pipeline_ticks++;
+
+        // actuate, offline interfaces refuse the frames during a replay
+        Hardware::DJIMotorManager::tick();
+        pipeline_last_tx = std::chrono::steady_clock::now();
+        if (oldest != Device::DeviceBase::time_point{}) {
+            pipeline.e2e.record(ns(pipeline_last_tx - oldest));
+        }
+    }
+
+    void Robot_ctrl::io_diagnostics_task() {
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(Config::IO_DIAG_PERIOD_MS));
+            IO::io<CAN>.for_each([](IO::Can_interface& can) {
+                can.diagnostics([&](const std::string& key, double value) {
+                    logger.push_value("can." + can.name + "." + key, value);
+                });
+            });
+            IO::io<SERIAL>.for_each([](IO::Serial_interface& serial) {
+                serial.diagnostics([&](const std::string& key, double value) {
+                    logger.push_value("serial." + serial.name + "." + key, value);
+                });
+            });
+            IO::io<SOCKET>.for_each([](IO::Server_socket_interface& socket) {
+                socket.diagnostics([&](const std::string& key, double value) {
+                    logger.push_value("socket." + socket.name + "." + key, value);
+                });
+            });
+            executor.diagnostics([](const std::string& key, double value) {
+                logger.push_value("loop." + key, value);
+            });
+            IO::reactor.diagnostics([](const std::string& key, double value) {
+                logger.push_value("reactor." + key, value);
+            });
+            UserLib::topic_bus.diagnostics([](const std::string& key, double value) {
+                logger.push_value("bus." + key, value);
+            });
+            if (Config::CONTROL_PIPELINE) {
+                auto publish = [](const std::string& key, const UserLib::Histogram& hist) {
+                    logger.push_value("pipeline." + key + "_p50_us", hist.percentile(0.5) / 1e3);
+                    logger.push_value("pipeline." + key + "_p99_us", hist.percentile(0.99) / 1e3);
+                    logger.push_value("pipeline." + key + "_max_us", hist.max() / 1e3);
+                };
+                publish("rx_wait", pipeline.rx_wait);
+                publish("e2e", pipeline.e2e);
+                uint64_t timeouts = pipeline.rx_timeouts.load(std::memory_order_relaxed);
+                logger.push_value("pipeline.rx_timeouts", timeouts - pipeline_last_timeouts);
+                pipeline_last_timeouts = timeouts;
+            }
+        }
+    }
+
+    void Robot_ctrl::exit_task(sigset_t set) {
+        int sig = 0;
+        sigwait(&set, &sig);
+        LOG_INFO("signal %d, stopping the control loops\n", sig);
+        executor.stop();
+        executor.report();
+        IO::reactor.report();
+        UserLib::topic_bus.report();
+        if (Config::CONTROL_PIPELINE) {
+            LOG_INFO(
+                "pipeline: rx wait p50 %.1fus p99 %.1fus, %lu timeouts, feedback -> command "
+                "p50 %.1fus p99 %.1fus max %.1fus\n",
+                pipeline.rx_wait.percentile(0.5) / 1e3,
+                pipeline.rx_wait.percentile(0.99) / 1e3,
+                pipeline.rx_timeouts.load(std::memory_order_relaxed),
+                pipeline.e2e.percentile(0.5) / 1e3,
+                pipeline.e2e.percentile(0.99) / 1e3,
+                pipeline.e2e.max() / 1e3);
+        }
+        fflush(stdout);
+        // IO, referee and logger threads never return, don't wait for them
+        std::_Exit(0);
     }
 
     void Robot_ctrl::join() {
@@ -60,15 +258,54 @@ namespace Robot
         std::this_thread::sleep_for(std::chrono::seconds(1000));
     }
 
-    void Robot_ctrl::load_hardware() {
+    void Robot_ctrl::load_hardware(bool replay) {
+        replay_mode = replay;
+        if (replay) {
+            // Can_interface::replay is then the only thread dispatching CAN callbacks
+            IO::io<CAN>.passive();
+            IO::io<SERIAL>.passive();
+            IO::io<SOCKET>.passive();
+        } else if (Config::IO_REACTOR_WORKERS > 0) {
+            IO::reactor.start(Config::IO_REACTOR_WORKERS);
+            IO::io<CAN>.use_reactor(IO::reactor);
+            IO::io<SERIAL>.use_reactor(IO::reactor);
+            IO::io<SOCKET>.use_reactor(IO::reactor);
+        }
+        // a replay owns no bus, its CAN interfaces only carry the callbacks
         for (auto& name : Config::CanInitList) {
-            IO::io<CAN>.insert(name);
+            IO::io<CAN>.insert(name, replay);
         }
-        for (auto& [name, baud_rate, simple_timeout] : Config::SerialInitList) {
-            IO::io<SERIAL>.insert(name, baud_rate, simple_timeout);
+        if (!replay && !Config::CAN_CAPTURE_DIR.empty()) {
+            for (auto& name : Config::CanInitList) {
+                auto path = Config::CAN_CAPTURE_DIR + "/" + name + ".gkdtrace";
+                IO::io<CAN>[name]->start_capture(path);
+            }
+        }
+        for (auto& name : Config::CanFdList) {
+            IO::io<CAN>[name]->enable_fd();
+        }
+        for (auto& [name, bridge_id] : Config::DJIMotorFdBridgeList) {
+            auto can = IO::io<CAN>[name];
+            if (can == nullptr || !can->fd_enabled()) {
+                LOG_ERR("CAN %s: FD is off, DJI motors keep the classic packer\n", name.c_str());
+                continue;
+            }
+            Hardware::DJIMotorManager::set_packer(
+                name, Hardware::DJIMotorManager::fd_bridge_packer(bridge_id));
         }
         for (auto& name : Config::SocketInitList) {
-            IO::io<SOCKET>.insert(name);
+            bool shm =
+                std::ranges::find(Config::SocketShmList, name) != Config::SocketShmList.end();
+            IO::io<SOCKET>.insert(name, shm);
+        }
+        if (replay) {
+            // nor any serial port, the serial devices log that theirs is missing
+            return;
+        }
+        for (auto& [name, baud_rate, simple_timeout] : Config::SerialInitList) {
+            bool low_latency = std::ranges::find(Config::SerialLowLatencyList, name) !=
+                               Config::SerialLowLatencyList.end();
+            IO::io<SERIAL>.insert(name, baud_rate, simple_timeout, low_latency);
         }
     }
 };  // namespace Robot
@@ -35,68 +35,68 @@ namespace Shoot
         trigger.enable();
     }
 
-    [[noreturn]] void Shoot::task() {
-        while (true) {
-            if (robot_set->mode == Types::ROBOT_MODE::ROBOT_NO_FORCE) {
-                left_friction.set(0);
-                right_friction.set(0);
-                trigger.set(0);
-            }
+    void Shoot::tick() {
+        auto in = robot_set->inputs();
+        auto mode = in.mode();
+        if (mode == Types::ROBOT_MODE::ROBOT_NO_FORCE) {
+            left_friction.set(0);
+            right_friction.set(0);
+            trigger.set(0);
+        }
 
-            friction_ramp.update(robot_set->friction_open ? Config::FRICTION_MAX_SPEED : 0.f);
+        friction_ramp.update(in.friction_open() ? Config::FRICTION_MAX_SPEED : 0.f);
 
-            // friction really open?
-            robot_set->friction_real_state =
-                left_friction.data_.output_linear_velocity < 0.5 &&
-                        right_friction.data_.output_linear_velocity < 0.5
-                    ? false
-                    : true;
-            // LOG_INFO(
-            //     "ramp %f %f\n", friction_ramp.out, right_friction.data_.output_linear_velocity);
-            left_friction.set(-friction_ramp.out);
-            right_friction.set(friction_ramp.out);
-            // if(left_friction.data_.output_linear_velocity || right_friction.data_.output_linear_velocity )
-            // {
-            //     //LOG_INFO("set: %f,left: %f, right: %f\n", friction_ramp.out, left_friction.data_.output_linear_velocity, right_friction.data_.output_linear_velocity);
-            //     std::stringstream ss;
-            //      ss << "set: " << friction_ramp.out
-            //     << ", left: " << left_friction.data_.output_linear_velocity 
-            //     << ", right: " << right_friction.data_.output_linear_velocity 
-            //     << "\n";
-            //     std::string log_content = ss.str();
-            //     logger.into_txt("../../../../log/fric_log.txt", log_content);
+        // friction really open?
+        robot_set->friction_real_state =
+            left_friction.data_.output_linear_velocity < 0.5 &&
+                    right_friction.data_.output_linear_velocity < 0.5
+                ? false
+                : true;
+        // LOG_INFO(
+        //     "ramp %f %f\n", friction_ramp.out, right_friction.data_.output_linear_velocity);
+        left_friction.set(-friction_ramp.out);
+        right_friction.set(friction_ramp.out);
+        // if(left_friction.data_.output_linear_velocity || right_friction.data_.output_linear_velocity )
+        // {
+        //     //LOG_INFO("set: %f,left: %f, right: %f\n", friction_ramp.out, left_friction.data_.output_linear_velocity, right_friction.data_.output_linear_velocity);
+        //     std::stringstream ss;
+        //      ss << "set: " << friction_ramp.out
+        //     << ", left: " << left_friction.data_.output_linear_velocity 
+        //     << ", right: " << right_friction.data_.output_linear_velocity 
+        //     << "\n";
+        //     std::string log_content = ss.str();
+        //     logger.into_txt("../../../../log/fric_log.txt", log_content);
 
-            // }
-            bool shoot_heat = true;
+        // }
+        bool shoot_heat = true;
 
-            bool remain_bullet = MUXDEF(
-                CONFIG_HERO,
-                robot_set->referee_info.bullet_allowance_data.bullet_allowance_num_42_mm > 0,
-                MUXDEF(
-                    CONFIG_INFANTRY,
-                    robot_set->referee_info.bullet_allowance_data.bullet_allowance_num_17_mm > 0,
-                    robot_set->referee_info.bullet_allowance_data.bullet_allowance_num_17_mm > 0));
+        auto referee = robot_set->referee_info.load();
+        bool remain_bullet = MUXDEF(
+            CONFIG_HERO,
+            referee.bullet_allowance_data.bullet_allowance_num_42_mm > 0,
+            MUXDEF(
+                CONFIG_INFANTRY,
+                referee.bullet_allowance_data.bullet_allowance_num_17_mm > 0,
+                referee.bullet_allowance_data.bullet_allowance_num_17_mm > 0));
 
-            bool referee_fire_allowance =
-                (shoot_heat && remain_bullet) ||
-                !((robot_set->referee_info.game_status_data.game_progress & 0x0f) == 4);
+        bool referee_fire_allowance =
+            (shoot_heat && remain_bullet) ||
+            !((referee.game_status_data.game_progress & 0x0f) == 4);
 
-            // LOG_INFO(
-            //     "referee fire allowance %d %d %d %d %d\n",
-            //     referee_fire_allowance,
-            //     remain_bullet,
-            //     shoot_heat,
-            //     robot_set->referee_info.power_heat_data.shooter_id_1_17_mm_cooling_heat,
-            //     robot_set->referee_info.game_robot_status_data.shooter_cooling_limit);
+        // LOG_INFO(
+        //     "referee fire allowance %d %d %d %d %d\n",
+        //     referee_fire_allowance,
+        //     remain_bullet,
+        //     shoot_heat,
+        //     robot_set->referee_info.power_heat_data.shooter_id_1_17_mm_cooling_heat,
+        //     robot_set->referee_info.game_robot_status_data.shooter_cooling_limit);
 
-            if (robot_set->mode == Types::ROBOT_MODE::ROBOT_NO_FORCE ||
-                !(robot_set->shoot_open & gimbal_id) || !referee_fire_allowance ||
-                !robot_set->friction_real_state) {
-                trigger.set(0);
-            } else {
-                trigger.set(Config::CONTINUE_TRIGGER_SPEED);
-            }
-            UserLib::sleep_ms(Config::SHOOT_CONTROL_TIME);
+        if (mode == Types::ROBOT_MODE::ROBOT_NO_FORCE || !(in.shoot_open() & gimbal_id) ||
+            !referee_fire_allowance ||
+            !robot_set->friction_real_state) {
+            trigger.set(0);
+        } else {
+            trigger.set(Config::CONTINUE_TRIGGER_SPEED);
         }
     }
 
@@ -0,0 +1,186 @@
+#include "periodic_executor.hpp"
+
+#include <time.h>
+
+#include <cerrno>
+
+#include "rt_profile.hpp"
+#include "utils.hpp"
+
+namespace UserLib
+{
+    namespace
+    {
+        // steady_clock is CLOCK_MONOTONIC, so its time points can go straight to clock_nanosleep
+        void sleep_until(PeriodicExecutor::Clock::time_point deadline) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          deadline.time_since_epoch())
+                          .count();
+            timespec ts{ static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000) };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+            }
+        }
+    }  // namespace
+
+    PeriodicExecutor::PeriodicExecutor()
+        : epoch(Clock::now()) {
+    }
+
+    PeriodicExecutor::~PeriodicExecutor() {
+        stop();
+    }
+
+    const PeriodicExecutor::Task &PeriodicExecutor::add(
+        std::string name,
+        std::chrono::nanoseconds period,
+        std::chrono::nanoseconds phase,
+        std::function<void()> tick,
+        Overrun policy) {
+        auto &task = tasks.emplace_back();
+        task.name = std::move(name);
+        task.period = period;
+        task.phase = phase;
+        task.policy = policy;
+        task.tick = std::move(tick);
+        task.budget = period * budget_percent / 100;
+        task.thread = std::jthread([this, &task](std::stop_token stop) { run(task, stop); });
+        rt_profile.apply(task.name, task.thread.native_handle());
+        LOG_OK(
+            "executor: %s every %ldus at +%ldus\n",
+            task.name.c_str(),
+            static_cast<long>(period.count() / 1000),
+            static_cast<long>(phase.count() / 1000));
+        return task;
+    }
+
+    void PeriodicExecutor::set_budget(uint32_t percent) {
+        budget_percent = percent;
+    }
+
+    void PeriodicExecutor::stop() {
+        for (auto &task : tasks) {
+            task.thread.request_stop();
+        }
+        for (auto &task : tasks) {
+            if (task.thread.joinable()) {
+                task.thread.join();
+            }
+        }
+    }
+
+    void PeriodicExecutor::stop(const std::string &name) {
+        for (auto &task : tasks) {
+            if (task.name == name && task.thread.joinable()) {
+                task.thread.request_stop();
+                task.thread.join();
+            }
+        }
+    }
+
+    void PeriodicExecutor::run(Task &task, const std::stop_token &stop) {
+        rt_profile.prefault_stack();
+
+        auto since = Clock::now() - epoch - task.phase;
+        auto first = since.count() < 0 ? 0 : since / task.period + 1;
+        auto next = epoch + task.phase + first * task.period;
+        auto ns = [](Clock::duration d) {
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        };
+        Clock::time_point last_start;
+        int behind = 0;
+        while (!stop.stop_requested()) {
+            sleep_until(next);
+            auto start = Clock::now();
+            task.stats.wake_latency.record(start > next ? ns(start - next) : 0);
+            if (last_start != Clock::time_point{}) {
+                task.stats.period.record(ns(start - last_start));
+            }
+            last_start = start;
+
+            task.tick();
+
+            auto now = Clock::now();
+            task.stats.exec.record(ns(now - start));
+            if (now - start > task.budget) {
+                task.stats.over_budget.fetch_add(1, std::memory_order_relaxed);
+            }
+            task.stats.ticks.fetch_add(1, std::memory_order_relaxed);
+
+            next += task.period;
+            if (now < next) {
+                behind = 0;
+                continue;
+            }
+            task.stats.overruns.fetch_add(1, std::memory_order_relaxed);
+            if (task.policy == Overrun::CATCH_UP && ++behind <= MAX_CATCH_UP) {
+                // next is already due, the loop runs it without sleeping
+                continue;
+            }
+            behind = 0;
+            auto missed = (now - next) / task.period + 1;
+            task.stats.skipped.fetch_add(missed, std::memory_order_relaxed);
+            if (task.policy == Overrun::RESET) {
+                next = now + task.period;
+            } else {
+                next += missed * task.period;
+            }
+        }
+    }
+
+    void PeriodicExecutor::diagnostics(const Publish &publish) {
+        for (auto &task : tasks) {
+            auto &stats = task.stats;
+            auto histogram = [&](const std::string &key, const Histogram &hist) {
+                if (hist.count() == 0) {
+                    return;
+                }
+                publish(task.name + "." + key + "_p50_us", hist.percentile(0.5) / 1e3);
+                publish(task.name + "." + key + "_p99_us", hist.percentile(0.99) / 1e3);
+                publish(task.name + "." + key + "_max_us", hist.max() / 1e3);
+            };
+            histogram("period", stats.period);
+            histogram("exec", stats.exec);
+            histogram("wake", stats.wake_latency);
+
+            auto counter = [&](const std::string &key, uint64_t now, uint64_t &last) {
+                publish(task.name + "." + key, now - last);
+                last = now;
+            };
+            counter("overruns", stats.overruns.load(std::memory_order_relaxed), task.last_overruns);
+            counter("skipped", stats.skipped.load(std::memory_order_relaxed), task.last_skipped);
+            counter(
+                "over_budget",
+                stats.over_budget.load(std::memory_order_relaxed),
+                task.last_over_budget);
+        }
+    }
+
+    void PeriodicExecutor::report() const {
+        for (const auto &task : tasks) {
+            const auto &stats = task.stats;
+            LOG_INFO(
+                "loop %s: %lu ticks every %.0fus, %lu overruns, %lu skipped, "
+                "%lu over %.0fus budget\n",
+                task.name.c_str(),
+                stats.ticks.load(std::memory_order_relaxed),
+                task.period.count() / 1e3,
+                stats.overruns.load(std::memory_order_relaxed),
+                stats.skipped.load(std::memory_order_relaxed),
+                stats.over_budget.load(std::memory_order_relaxed),
+                task.budget.count() / 1e3);
+            auto line = [&](const char *key, const Histogram &hist) {
+                LOG_INFO(
+                    "    %-6s p50 %8.1fus p99 %8.1fus p99.9 %8.1fus max %8.1fus\n",
+                    key,
+                    hist.percentile(0.5) / 1e3,
+                    hist.percentile(0.99) / 1e3,
+                    hist.percentile(0.999) / 1e3,
+                    hist.max() / 1e3);
+            };
+            line("period", stats.period);
+            line("exec", stats.exec);
+            line("wake", stats.wake_latency);
+        }
+    }
+}  // namespace UserLib
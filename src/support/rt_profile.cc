@@ -0,0 +1,134 @@
+#include "rt_profile.hpp"
+
+#include <alloca.h>
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "utils.hpp"
+
+namespace UserLib
+{
+    bool RtProfile::select(const std::vector<Profile> &profiles, const std::string &name) {
+        auto it = std::ranges::find(profiles, name, &Profile::name);
+        if (it == profiles.end()) {
+            LOG_ERR("rt profile error: no profile named %s\n", name.c_str());
+            return false;
+        }
+        std::unique_lock guard(lock);
+        selected = *it;
+        active = true;
+        if (selected.lock_memory) {
+            // freed heap stays mapped and locked instead of going back to the kernel
+            mallopt(M_TRIM_THRESHOLD, -1);
+            mallopt(M_MMAP_MAX, 0);
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+                mlock_error = errno;
+            }
+        }
+        guard.unlock();
+        prefault_stack();
+        return true;
+    }
+
+    void RtProfile::apply(const std::string &name, pthread_t thread) {
+        // pthread names are limited to 15 characters
+        pthread_setname_np(thread, name.substr(0, 15).c_str());
+        std::unique_lock guard(lock);
+        if (!active) {
+            return;
+        }
+        auto it = std::ranges::find(selected.threads, name, &Thread::name);
+        if (it == selected.threads.end()) {
+            return;
+        }
+        Applied result{ *it };
+        if (it->priority > 0) {
+            sched_param param{};
+            param.sched_priority = it->priority;
+            result.sched_error = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        }
+        if (it->cpus != 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu = 0; cpu < 64; cpu++) {
+                if (it->cpus >> cpu & 1) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            result.affinity_error = pthread_setaffinity_np(thread, sizeof(set), &set);
+        }
+        applied.push_back(result);
+    }
+
+    void RtProfile::prefault_stack() const {
+        size_t size;
+        {
+            std::unique_lock guard(lock);
+            size = active ? selected.prefault_stack : 0;
+        }
+        if (size == 0) {
+            return;
+        }
+        auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto stack = static_cast<volatile uint8_t *>(alloca(size));
+        for (size_t i = 0; i < size; i += page) {
+            stack[i] = 0;
+        }
+    }
+
+    void RtProfile::report() const {
+        std::unique_lock guard(lock);
+        if (!active) {
+            LOG_INFO("rt profile: none, every thread is SCHED_OTHER\n");
+            return;
+        }
+        LOG_INFO(
+            "rt profile %s: mlockall %s, stack prefault %zu KiB, %ld cpus online\n",
+            selected.name.c_str(),
+            selected.lock_memory ? (mlock_error == 0 ? "on" : "FAILED") : "off",
+            selected.prefault_stack / 1024,
+            sysconf(_SC_NPROCESSORS_ONLN));
+        if (mlock_error != 0) {
+            LOG_ERR(
+                "rt profile: mlockall denied (%s), raise RLIMIT_MEMLOCK\n", strerror(mlock_error));
+        }
+        for (const auto &result : applied) {
+            const auto &thread = result.thread;
+            LOG_INFO(
+                "rt %-15s %s %2d cpus 0x%lx\n",
+                thread.name.c_str(),
+                thread.priority > 0 ? "FIFO " : "OTHER",
+                thread.priority,
+                thread.cpus);
+            if (result.sched_error != 0) {
+                LOG_ERR(
+                    "rt profile: SCHED_FIFO %d denied for %s (%s), needs CAP_SYS_NICE or "
+                    "RLIMIT_RTPRIO\n",
+                    thread.priority,
+                    thread.name.c_str(),
+                    strerror(result.sched_error));
+            }
+            if (result.affinity_error != 0) {
+                LOG_ERR(
+                    "rt profile: cpus 0x%lx denied for %s (%s)\n",
+                    thread.cpus,
+                    thread.name.c_str(),
+                    strerror(result.affinity_error));
+            }
+        }
+        for (const auto &thread : selected.threads) {
+            auto name = [](const Applied &a) -> const std::string & {
+                return a.thread.name;
+            };
+            if (std::ranges::find(applied, thread.name, name) == applied.end()) {
+                LOG_INFO("rt %-15s not running\n", thread.name.c_str());
+            }
+        }
+    }
+}  // namespace UserLib
@@ -0,0 +1,57 @@
+#include "topic.hpp"
+
+#include "utils.hpp"
+
+namespace UserLib
+{
+    void TopicBus::diagnostics(const Publish &publish) {
+        std::unique_lock guard(lock);
+        auto now = TopicBase::Clock::now();
+        for (auto &[name, topic] : topics) {
+            uint64_t published = topic->published();
+            uint64_t torn = topic->torn();
+            uint64_t overlapped = topic->overlapped();
+            std::chrono::duration<double> window = now - topic->last_diagnostics;
+            if (window.count() > 0) {
+                publish(name + ".hz", (published - topic->last_published) / window.count());
+            }
+            publish(name + ".torn", torn - topic->last_torn);
+            publish(name + ".overlap", overlapped - topic->last_overlapped);
+            if (published != 0) {
+                publish(
+                    name + ".age_ms",
+                    std::chrono::duration<double, std::milli>(now - topic->last_stamp()).count());
+            }
+            publish(name + ".stale", topic->stale());
+            topic->last_published = published;
+            topic->last_torn = torn;
+            topic->last_overlapped = overlapped;
+            topic->last_diagnostics = now;
+        }
+    }
+
+    void TopicBus::report() const {
+        std::unique_lock guard(lock);
+        auto now = TopicBase::Clock::now();
+        for (const auto &[name, topic] : topics) {
+            uint64_t published = topic->published();
+            if (published == 0) {
+                LOG_INFO("topic %-28s never published\n", name.c_str());
+                continue;
+            }
+            LOG_INFO(
+                "topic %-28s %10lu msgs, last %.1fms ago%s, %lu torn reads\n",
+                name.c_str(),
+                published,
+                std::chrono::duration<double, std::milli>(now - topic->last_stamp()).count(),
+                topic->stale() ? " (stale)" : "",
+                topic->torn());
+            if (topic->overlapped() != 0) {
+                LOG_ERR(
+                    "topic %s: %lu publishes overlapped, it has more than one writer\n",
+                    name.c_str(),
+                    topic->overlapped());
+            }
+        }
+    }
+}  // namespace UserLib
@@ -9,6 +9,12 @@ namespace UserLib
         std::this_thread::sleep_for(std::chrono::milliseconds(dur));
     }
 
+    uint64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
     fp32 rad_format(fp32 ang) {
         fp32 ans = fmodf(ang + M_PIf, M_PIf * 2.f);
         return (ans < 0.f) ? ans + M_PIf : ans - M_PIf;
@@ -0,0 +1,96 @@
+// Microbenchmark: CAN-ID dispatch through the flat Callback_key<uint32_t, can_frame> table versus
+// the generic std::map based Callback_key, at 1, 8 and 32 registered IDs.
+//
+//   make bench && ./build/tools/callback_key_bench [frames]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "io_callback.hpp"
+
+namespace
+{
+    // the generic template is the pre-existing std::map implementation, a 64-bit key keeps the
+    // can_frame specialization out of the way
+    using MapDispatch = IO::Callback_key<uint64_t, can_frame>;
+    using TableDispatch = IO::Callback_key<uint32_t, can_frame>;
+
+    struct MapBench : MapDispatch
+    {
+        using MapDispatch::callback_key;
+    };
+
+    struct TableBench : TableDispatch
+    {
+        using TableDispatch::callback_key;
+    };
+
+    volatile uint64_t sink = 0;
+
+    std::vector<uint32_t> make_ids(int num) {
+        // DJI motor feedback, M9025, super cap and a few spare ids, like a crowded bus
+        std::vector<uint32_t> ids;
+        for (uint32_t id = 0x201; id <= 0x20B && static_cast<int>(ids.size()) < num; id++) {
+            ids.push_back(id);
+        }
+        for (uint32_t id = 0x141; static_cast<int>(ids.size()) < num; id++) {
+            ids.push_back(id);
+        }
+        if (num > 1) {
+            ids.back() = 0x51;
+        }
+        return ids;
+    }
+
+    template<typename F>
+    double measure(size_t frames, F &&dispatch) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames; i++) {
+            dispatch(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / frames;
+    }
+}  // namespace
+
+int main(int argc, char **argv) {
+    size_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+
+    printf("%8s %14s %14s %8s\n", "ids", "map ns/frame", "table ns/frame", "speedup");
+    for (int num : { 1, 8, 32 }) {
+        auto ids = make_ids(num);
+
+        MapBench map;
+        TableBench table;
+        for (auto id : ids) {
+            map.register_callback_key(
+                id, [](const can_frame &frame) { sink = sink + frame.data[0]; });
+            table.register_callback_key(
+                id, [](void *, const can_frame &frame) { sink = sink + frame.data[0]; }, nullptr);
+        }
+
+        // every 8th frame carries an id nobody registered, as on a shared bus
+        std::vector<can_frame> stream(1024);
+        for (size_t i = 0; i < stream.size(); i++) {
+            stream[i] = {};
+            stream[i].can_id = i % 8 == 7 ? 0x300 + i % 16 : ids[i % ids.size()];
+            stream[i].len = 8;
+            stream[i].data[0] = static_cast<uint8_t>(i);
+        }
+        size_t mask = stream.size() - 1;
+
+        double map_ns = measure(frames, [&](size_t i) {
+            auto &frame = stream[i & mask];
+            map.callback_key(frame.can_id, frame);
+        });
+        double table_ns = measure(frames, [&](size_t i) {
+            auto &frame = stream[i & mask];
+            table.callback_key(frame.can_id, frame);
+        });
+        printf("%8d %14.2f %14.2f %7.1fx\n", num, map_ns, table_ns, map_ns / table_ns);
+    }
+    return 0;
+}
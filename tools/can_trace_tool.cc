@@ -0,0 +1,101 @@
+// Inspect .gkdtrace captures written by Can_interface::start_capture.
+//
+//   can_trace_tool candump <trace> [--rx-only]   print as `candump -l` log lines
+//   can_trace_tool info <trace>                  frame counts, duration and per-ID rates
+//
+// candump -l stamps are wall clock, the trace's monotonic stamps are shifted by the
+// realtime offset stored in its header. Replay itself runs inside the robot binary:
+//   ./build/rx78-2 --can-replay can0.gkdtrace [--replay-fast]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "can_trace.hpp"
+
+namespace
+{
+    int candump(IO::CanTraceReader &trace, bool rx_only) {
+        const auto &header = trace.header();
+        IO::CanTraceReader::Frame record;
+        while (trace.next(record)) {
+            if (rx_only && record.tx) {
+                continue;
+            }
+            int64_t ns = static_cast<int64_t>(record.ts_ns) + header.realtime_offset_ns;
+            const auto &frame = record.frame;
+            bool eff = frame.can_id & CAN_EFF_FLAG;
+            printf("(%ld.%06ld) %s ", ns / 1000000000, ns % 1000000000 / 1000, header.interface);
+            if (eff) {
+                printf("%08X", frame.can_id & CAN_EFF_MASK);
+            } else {
+                printf("%03X", frame.can_id & CAN_SFF_MASK);
+            }
+            if (record.fd) {
+                printf("##%X", frame.flags & 0xf);
+            } else {
+                printf("#");
+            }
+            if (!record.fd && (frame.can_id & CAN_RTR_FLAG)) {
+                printf("R");
+            } else {
+                for (int i = 0; i < frame.len; i++) {
+                    printf("%02X", frame.data[i]);
+                }
+            }
+            printf("\n");
+        }
+        return 0;
+    }
+
+    int info(IO::CanTraceReader &trace) {
+        struct IdStats
+        {
+            uint64_t rx = 0;
+            uint64_t tx = 0;
+        };
+        std::map<uint32_t, IdStats> ids;
+        IO::CanTraceReader::Frame record;
+        uint64_t first = 0, last = 0, total = 0, fd = 0;
+        while (trace.next(record)) {
+            if (total++ == 0) {
+                first = record.ts_ns;
+            }
+            last = record.ts_ns;
+            fd += record.fd;
+            auto &id = ids[record.frame.can_id];
+            (record.tx ? id.tx : id.rx)++;
+        }
+        double seconds = (last - first) / 1e9;
+        printf("interface %s: %lu frame(s), %lu FD, %.3fs\n",
+               trace.header().interface, total, fd, seconds);
+        printf("%10s %10s %10s %10s\n", "id", "rx", "tx", "rx/s");
+        for (auto &[can_id, s] : ids) {
+            printf("%10X %10lu %10lu %10.1f\n",
+                   can_id, s.rx, s.tx, seconds > 0 ? s.rx / seconds : 0.);
+        }
+        return 0;
+    }
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s candump|info <trace> [--rx-only]\n", argv[0]);
+        return -1;
+    }
+    IO::CanTraceReader trace;
+    if (!trace.open(argv[2])) {
+        fprintf(stderr, "can't read %s\n", argv[2]);
+        return -1;
+    }
+    if (strcmp(argv[1], "candump") == 0) {
+        return candump(trace, argc > 3 && strcmp(argv[3], "--rx-only") == 0);
+    }
+    if (strcmp(argv[1], "info") == 0) {
+        return info(trace);
+    }
+    fprintf(stderr, "unknown command %s\n", argv[1]);
+    return -1;
+}
@@ -0,0 +1,366 @@
+// Hardware-free plant for `make sim`: answers DJI 0x200/0x1FF/0x2FF current commands on vcan with
+// first-order M3508/M6020/M2006 feedback at 1 kHz, and serves ReceivePacket_IMU/RC_CTRL over a PTY
+// in place of /dev/IMU_*. The IMU follows the simulated gimbal motors so the loops close.
+//
+//   sudo scripts/sim_vcan.sh
+//   make sim && ./build/tools/plant_sim &
+//   ./build/rx78-2
+//
+// options:
+//   --motor bus:type:id     add a motor (repeatable, replaces the default infantry layout)
+//   --imu-yaw bus:type:id   motor whose output angle is reported as IMU yaw   (vcan0:6020:1)
+//   --imu-pitch bus:type:id motor whose output angle is reported as IMU pitch (vcan0:6020:2)
+//   --pty path              PTY symlink (/tmp/gkd_sim/IMU)
+//   --imu-hz n / --rc-hz n  serial packet rates (1000 / 70)
+//   --framing legacy|v2     serial frame format (v2)
+//   --duration s            exit after s seconds, 0 runs until SIGINT
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pty_link.hpp"
+#include "serial_protocol.hpp"
+#include "types.hpp"
+
+namespace
+{
+    // same values as rc_controller.hpp
+    constexpr int S_DOWN = 2;
+    constexpr int ROLL_UP_MAX = -660;
+
+    struct Model
+    {
+        int cmd_max;        // |command| accepted by the ESC
+        float rotor_w_max;  // steady rotor speed at cmd_max (rad/s)
+        float tau;          // speed time constant with a typical load (s)
+        float ratio;        // output / rotor
+    };
+
+    Model model_of(int type) {
+        switch (type) {
+            // 20 A, 482 rpm output through 3591/187
+            case 3508: return { 16384, 9000 * 2 * M_PIf / 60, 0.05f, 1.f / 19.f };
+            // voltage mode, 320 rpm no-load at 24 V
+            case 6020: return { 30000, 320 * 2 * M_PIf / 60, 0.03f, 1.f };
+            // 10 A, 500 rpm output through 36:1
+            case 2006: return { 10000, 18000 * 2 * M_PIf / 60, 0.02f, 1.f / 36.f };
+            default: fprintf(stderr, "unknown motor type %d\n", type); exit(-1);
+        }
+    }
+
+    struct Motor
+    {
+        std::string bus;
+        int type = 0;
+        int id = 0;
+        Model model{};
+        uint32_t cmd_id = 0;
+        int cmd_offset = 0;
+        uint32_t feedback_id = 0;
+
+        int16_t cmd = 0;
+        float w = 0;      // rotor speed (rad/s)
+        float theta = 0;  // rotor angle (rad)
+        float temp = 25;
+        std::atomic<float> out_angle{ 0 };
+        std::atomic<float> out_velocity{ 0 };
+
+        void step(float dt) {
+            float target = static_cast<float>(cmd) / model.cmd_max * model.rotor_w_max;
+            w += (target - w) * std::min(dt / model.tau, 1.f);
+            theta = std::remainder(theta + w * dt, 2 * M_PIf);
+            float load = static_cast<float>(cmd) / model.cmd_max;
+            temp += ((25 + 40 * load * load) - temp) * dt / 30;
+            out_angle.store(theta * model.ratio, std::memory_order_relaxed);
+            out_velocity.store(w * model.ratio, std::memory_order_relaxed);
+        }
+
+        can_frame feedback() const {
+            can_frame frame{};
+            frame.can_id = feedback_id;
+            frame.len = 8;
+            float wrapped = theta < 0 ? theta + 2 * M_PIf : theta;
+            auto ecd = static_cast<uint16_t>(wrapped / (2 * M_PIf) * 8192) & 0x1fff;
+            auto rpm = static_cast<int16_t>(w * 60 / (2 * M_PIf));
+            frame.data[0] = ecd >> 8;
+            frame.data[1] = ecd & 0xff;
+            frame.data[2] = static_cast<uint16_t>(rpm) >> 8;
+            frame.data[3] = rpm & 0xff;
+            frame.data[4] = static_cast<uint16_t>(cmd) >> 8;
+            frame.data[5] = cmd & 0xff;
+            frame.data[6] = static_cast<uint8_t>(temp);
+            return frame;
+        }
+    };
+
+    // DJI id layout, mirrors DJIMotor's constructor
+    std::unique_ptr<Motor> make_motor(const std::string &spec) {
+        auto motor = std::make_unique<Motor>();
+        char bus[IFNAMSIZ] = {};
+        if (sscanf(spec.c_str(), "%15[^:]:%d:%d", bus, &motor->type, &motor->id) != 3) {
+            fprintf(stderr, "bad motor spec %s, want bus:type:id\n", spec.c_str());
+            exit(-1);
+        }
+        motor->bus = bus;
+        motor->model = model_of(motor->type);
+        int id = motor->id;
+        if (motor->type == 6020) {
+            motor->feedback_id = 0x204 + id;
+            motor->cmd_id = id <= 4 ? 0x1ff : 0x2ff;
+            motor->cmd_offset = ((id - 1) % 4) * 2;
+        } else {
+            motor->feedback_id = 0x200 + id;
+            motor->cmd_id = id <= 4 ? 0x200 : 0x1ff;
+            motor->cmd_offset = ((id - 1) % 4) * 2;
+        }
+        return motor;
+    }
+
+    std::atomic<bool> running{ true };
+
+    void on_signal(int) {
+        running = false;
+    }
+
+    void sleep_until(timespec &next, long period_ns) {
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+
+    int open_can(const std::string &bus) {
+        int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+        ifreq ifr{};
+        std::strncpy(ifr.ifr_name, bus.c_str(), IFNAMSIZ - 1);
+        if (fd < 0 || ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+            fprintf(stderr, "can't open %s, run scripts/sim_vcan.sh first\n", bus.c_str());
+            exit(-1);
+        }
+        sockaddr_can addr{};
+        addr.can_family = AF_CAN;
+        addr.can_ifindex = ifr.ifr_ifindex;
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+            perror("bind");
+            exit(-1);
+        }
+        // only the three command ids
+        can_filter filters[3];
+        uint32_t ids[3] = { 0x200, 0x1ff, 0x2ff };
+        for (int i = 0; i < 3; i++) {
+            filters[i] = { .can_id = ids[i], .can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG };
+        }
+        setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, sizeof(filters));
+        return fd;
+    }
+
+    struct BusStats
+    {
+        uint64_t commands = 0;
+        uint64_t feedback = 0;
+        uint64_t overruns = 0;
+    };
+
+    void run_bus(const std::string &bus, std::vector<Motor *> motors, BusStats &stats) {
+        int fd = open_can(bus);
+        constexpr long PERIOD_NS = 1000000;
+        constexpr float DT = PERIOD_NS / 1e9f;
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        while (running) {
+            can_frame frame;
+            while (recv(fd, &frame, sizeof(frame), MSG_DONTWAIT) == sizeof(frame)) {
+                stats.commands++;
+                for (auto motor : motors) {
+                    if (motor->cmd_id == frame.can_id) {
+                        int16_t cmd = static_cast<int16_t>(
+                            frame.data[motor->cmd_offset] << 8 | frame.data[motor->cmd_offset + 1]);
+                        motor->cmd = static_cast<int16_t>(
+                            std::clamp<int>(cmd, -motor->model.cmd_max, motor->model.cmd_max));
+                    }
+                }
+            }
+            for (auto motor : motors) {
+                motor->step(DT);
+                auto out = motor->feedback();
+                if (write(fd, &out, sizeof(out)) == sizeof(out)) {
+                    stats.feedback++;
+                } else {
+                    stats.overruns++;
+                }
+            }
+            sleep_until(next, PERIOD_NS);
+        }
+        close(fd);
+    }
+
+    template<typename T>
+    void send_packet(Tools::PtyLink &pty, bool v2, uint8_t id, uint8_t &seq, const T &pkg) {
+        uint8_t buf[IO::SerialProtocol::MAX_FRAME];
+        size_t len = v2 ? IO::SerialProtocol::encode_v2(id, seq++, &pkg, sizeof(T), buf)
+                        : IO::SerialProtocol::encode_legacy(id, &pkg, sizeof(T), buf);
+        pty.write_all(buf, len);
+    }
+
+    void run_serial(
+        const std::string &link,
+        bool v2,
+        int imu_hz,
+        int rc_hz,
+        const Motor *yaw,
+        const Motor *pitch) {
+        Tools::PtyLink pty(link);
+        uint8_t imu_seq = 0, rc_seq = 0;
+        long period_ns = 1000000000L / imu_hz;
+        int rc_every = std::max(imu_hz / std::max(rc_hz, 1), 1);
+        constexpr float DEG = 180 / M_PIf;
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        for (uint64_t tick = 0; running; tick++) {
+            Types::ReceivePacket_IMU imu{};
+            if (yaw != nullptr) {
+                imu.yaw = yaw->out_angle.load(std::memory_order_relaxed) * DEG;
+                imu.yaw_v = yaw->out_velocity.load(std::memory_order_relaxed) * DEG * 1000;
+            }
+            if (pitch != nullptr) {
+                // IMU::unpack flips pitch
+                imu.pitch = -pitch->out_angle.load(std::memory_order_relaxed) * DEG;
+                imu.pitch_v = pitch->out_velocity.load(std::memory_order_relaxed) * DEG * 1000;
+            }
+            send_packet(pty, v2, IO::SerialProtocol::IMU_ID, imu_seq, imu);
+
+            if (tick % rc_every == 0) {
+                // both switches down with the wheel rolled up is the init gesture Rc_Controller
+                // waits for, hold it for the first second then release the wheel
+                Types::ReceivePacket_RC_CTRL rc{};
+                rc.s1 = S_DOWN;
+                rc.s2 = S_DOWN;
+                rc.ch4 = tick < static_cast<uint64_t>(imu_hz) ? ROLL_UP_MAX : 0;
+                send_packet(pty, v2, IO::SerialProtocol::RC_ID, rc_seq, rc);
+            }
+            sleep_until(next, period_ns);
+        }
+    }
+
+    const char *arg_value(int &i, int argc, char **argv) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "%s needs a value\n", argv[i]);
+            exit(-1);
+        }
+        return argv[++i];
+    }
+}  // namespace
+
+int main(int argc, char **argv) {
+    // the infantry layout of config_infantry.hpp under CONFIG_SIM
+    std::vector<std::string> specs = {
+        "vcan1:3508:1", "vcan1:3508:2", "vcan1:3508:3", "vcan1:3508:4",
+        "vcan0:6020:1", "vcan0:6020:2", "vcan0:3508:1", "vcan0:3508:2", "vcan0:2006:3",
+    };
+    bool custom_motors = false;
+    std::string yaw_spec = "vcan0:6020:1";
+    std::string pitch_spec = "vcan0:6020:2";
+    std::string link = "/tmp/gkd_sim/IMU";
+    int imu_hz = 1000;
+    int rc_hz = 70;
+    bool v2 = true;
+    double duration = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--motor") {
+            if (!custom_motors) {
+                specs.clear();
+                custom_motors = true;
+            }
+            specs.emplace_back(arg_value(i, argc, argv));
+        } else if (arg == "--imu-yaw") {
+            yaw_spec = arg_value(i, argc, argv);
+        } else if (arg == "--imu-pitch") {
+            pitch_spec = arg_value(i, argc, argv);
+        } else if (arg == "--pty") {
+            link = arg_value(i, argc, argv);
+        } else if (arg == "--imu-hz") {
+            imu_hz = std::max(atoi(arg_value(i, argc, argv)), 1);
+        } else if (arg == "--rc-hz") {
+            rc_hz = atoi(arg_value(i, argc, argv));
+        } else if (arg == "--framing") {
+            v2 = std::string(arg_value(i, argc, argv)) != "legacy";
+        } else if (arg == "--duration") {
+            duration = atof(arg_value(i, argc, argv));
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return -1;
+        }
+    }
+
+    std::vector<std::unique_ptr<Motor>> motors;
+    std::map<std::string, std::vector<Motor *>> buses;
+    const Motor *yaw = nullptr;
+    const Motor *pitch = nullptr;
+    for (const auto &spec : specs) {
+        auto &motor = motors.emplace_back(make_motor(spec));
+        buses[motor->bus].push_back(motor.get());
+        if (spec == yaw_spec) {
+            yaw = motor.get();
+        }
+        if (spec == pitch_spec) {
+            pitch = motor.get();
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    std::map<std::string, BusStats> stats;
+    std::vector<std::thread> threads;
+    for (auto &[bus, list] : buses) {
+        printf("%s: %zu motor(s)\n", bus.c_str(), list.size());
+        threads.emplace_back(run_bus, bus, list, std::ref(stats[bus]));
+    }
+    threads.emplace_back(run_serial, link, v2, imu_hz, rc_hz, yaw, pitch);
+
+    auto start = std::chrono::steady_clock::now();
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (duration > 0 &&
+            std::chrono::steady_clock::now() - start > std::chrono::duration<double>(duration)) {
+            running = false;
+        }
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto &[bus, s] : stats) {
+        printf(
+            "%s: %lu command frame(s), %lu feedback frame(s), %lu tx overrun(s)\n",
+            bus.c_str(),
+            s.commands,
+            s.feedback,
+            s.overruns);
+    }
+    return 0;
+}
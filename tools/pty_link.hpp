@@ -0,0 +1,84 @@
+#pragma once
+
+// Pseudo terminal published under a fixed path, so a Serial_interface can open it in place of a
+// real /dev/IMU_* device. Shared by the hardware-free tools.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace Tools
+{
+    class PtyLink
+    {
+       public:
+        // creates the parent directory of link_path if needed and points link_path at the slave
+        explicit PtyLink(const std::string &link_path) : link(link_path) {
+            master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+            if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+                perror("pty");
+                exit(-1);
+            }
+            const char *slave = ptsname(master);
+
+            // raw slave: the reader sees exactly the bytes we write
+            int slave_fd = open(slave, O_RDWR | O_NOCTTY);
+            termios tio{};
+            tcgetattr(slave_fd, &tio);
+            cfmakeraw(&tio);
+            tcsetattr(slave_fd, TCSANOW, &tio);
+            close(slave_fd);
+
+            auto dir = link.substr(0, link.rfind('/'));
+            if (!dir.empty()) {
+                mkdir(dir.c_str(), 0755);
+            }
+            unlink(link.c_str());
+            if (symlink(slave, link.c_str()) < 0) {
+                perror("symlink");
+                exit(-1);
+            }
+            printf("pty %s -> %s\n", link.c_str(), slave);
+        }
+
+        ~PtyLink() {
+            unlink(link.c_str());
+            close(master);
+        }
+
+        PtyLink(const PtyLink &) = delete;
+        PtyLink &operator=(const PtyLink &) = delete;
+
+        // never blocks: bytes are dropped while nobody drains the slave side
+        bool write_all(const void *data, size_t len) {
+            auto p = static_cast<const uint8_t *>(data);
+            while (len > 0) {
+                auto n = ::write(master, p, len);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                p += n;
+                len -= n;
+            }
+            return true;
+        }
+
+        int fd() const {
+            return master;
+        }
+
+       private:
+        std::string link;
+        int master = -1;
+    };
+}  // namespace Tools
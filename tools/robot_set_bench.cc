@@ -0,0 +1,498 @@
+// False-sharing soak for Robot::Robot_set: one thread per writer and reader of the real robot (RC,
+// vision, the three gimbal loops, chassis, shoot, referee, super cap) touching the fields they
+// touch on the robot. It runs once on the old layout, with every field packed together and written
+// in place, and once on Robot::Robot_set, where every writer publishes its own SeqLock section and
+// the loops load Robot_set::inputs() once per tick. Every thread counts its own cache misses and
+// L1D load misses with perf_event_open and reports them per tick.
+//
+//   make tools && ./build/tools/robot_set_bench [seconds] [work]
+//
+// work is the private arithmetic done per tick between the shared accesses. The threads are
+// spread over the online cpus; with a single cpu there is no false sharing to measure. For the
+// full binary run the simulator (see README) and attach
+// `perf stat -e cache-misses,L1-dcache-load-misses -p $(pidof rx78-2)` once per layout.
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "robot.hpp"
+
+namespace
+{
+    // Robot_set before it was partitioned, same fields in the same order
+    struct PackedSet
+    {
+        uint8_t header;
+        fp32 vx_set = 0.f;
+        fp32 vy_set = 0.f;
+        fp32 wz_set = 0.f;
+        bool spin_state = false;
+
+        fp32 gimbal1_yaw_set = 0.f;
+        fp32 gimbal1_yaw_offset = 0.f;
+        fp32 gimbal1_pitch_set = 0.f;
+        fp32 gimbal2_yaw_set = 0.f;
+        fp32 gimbal2_yaw_offset = 0.f;
+        fp32 gimbal2_pitch_set = 0.f;
+        fp32 gimbal3_yaw_set = 0.f;
+        fp32 gimbal3_yaw_offset = 0.f;
+        fp32 gimbal3_pitch_set = 0.f;
+
+        bool friction_open = false;
+        bool friction_real_state = false;
+        bool cv_fire = false;
+        int shoot_open = 0;
+
+        fp32 gimbalT_1_yaw_set = 0.f;
+        fp32 gimbalT_1_pitch_set = 0.f;
+        fp32 gimbalT_1_yaw_reletive = 0.f;
+        fp32 gimbalT_2_yaw_set = 0.f;
+        fp32 gimbalT_2_pitch_set = 0.f;
+        fp32 gimbalT_2_yaw_reletive = 0.f;
+        fp32 gimbal_sentry_yaw_set = 0.f;
+        fp32 gimbal_sentry_yaw = 0.f;
+        fp32 gimbal_sentry_yaw_reletive = 0.f;
+
+        fp32 aimx;
+        fp32 aimy;
+        fp32 aimz;
+        bool is_aiming = false;
+        uint8_t inited = 0;
+        uint8_t sentry_follow_gimbal = 0;
+        bool auto_aim_status = false;
+
+        Types::ROBOT_MODE mode = Types::ROBOT_MODE::ROBOT_NO_FORCE;
+        Types::ROBOT_MODE last_mode = Types::ROBOT_MODE::ROBOT_NO_FORCE;
+
+        UserLib::SeqLock<Types::ReceivePacket_Super_Cap> super_cap_info;
+        UserLib::SeqLock<Types::Referee_info> referee_info;
+    };
+
+    // plain fields have no synchronization of their own, like the real ones before the sections;
+    // volatile keeps every access in the loop instead of in a register
+    template<typename T>
+    T rd(const T &field) {
+        return *static_cast<const volatile T *>(&field);
+    }
+
+    template<typename T>
+    void wr(T &field, T value) {
+        *static_cast<volatile T *>(&field) = value;
+    }
+
+    class Counter
+    {
+       public:
+        Counter(uint32_t type, uint64_t config) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        ~Counter() {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        void start() {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        // -1 when the kernel refused the counter (perf_event_paranoid, containers, no PMU)
+        int64_t stop() {
+            uint64_t value = 0;
+            if (fd < 0 || ioctl(fd, PERF_EVENT_IOC_DISABLE, 0) < 0 ||
+                read(fd, &value, sizeof(value)) != sizeof(value)) {
+                return -1;
+            }
+            return static_cast<int64_t>(value);
+        }
+
+       private:
+        int fd;
+    };
+
+    struct Result
+    {
+        const char *name;
+        uint64_t ticks = 0;
+        double ns = 0.;
+        int64_t cache_misses = -1;
+        int64_t l1d_misses = -1;
+    };
+
+    template<typename S>
+    struct Role
+    {
+        const char *name;
+        // multiple of work between ticks, the referee and the super cap are slower than the loops
+        int slow;
+        std::function<void(S &, uint32_t)> tick;
+    };
+
+    std::vector<Role<PackedSet>> packed_roles() {
+        using S = PackedSet;
+        using Types::ROBOT_MODE;
+        return {
+            { "rc",
+              4,
+              [](S &s, uint32_t i) {
+                  wr(s.vx_set, i * 1e-3f);
+                  wr(s.vy_set, i * 2e-3f);
+                  wr(s.wz_set, (i & 1) * 1.f);
+                  if (!rd(s.auto_aim_status)) {
+                      wr(s.gimbalT_1_yaw_set, rd(s.gimbalT_1_yaw_set) + 1e-4f);
+                  }
+                  wr(s.friction_open, rd(s.mode) != ROBOT_MODE::ROBOT_NO_FORCE);
+              } },
+            { "vision1",
+              2,
+              [](S &s, uint32_t i) {
+                  wr(s.gimbalT_1_yaw_set, i * 1e-4f);
+                  wr(s.gimbalT_1_pitch_set, i * -1e-4f);
+                  wr(s.cv_fire, (i & 7) == 0);
+                  wr(s.shoot_open, static_cast<int>(i & 3));
+              } },
+            { "vision2",
+              2,
+              [](S &s, uint32_t i) {
+                  wr(s.gimbalT_2_yaw_set, i * 1e-4f);
+                  wr(s.gimbalT_2_pitch_set, i * -1e-4f);
+              } },
+            { "gimbal1",
+              1,
+              [](S &s, uint32_t) {
+                  if (rd(s.mode) != ROBOT_MODE::ROBOT_NO_FORCE) {
+                      wr(s.gimbalT_1_yaw_reletive,
+                         rd(s.gimbalT_1_yaw_set) - rd(s.gimbal_sentry_yaw) +
+                             rd(s.gimbalT_1_pitch_set));
+                  }
+              } },
+            { "gimbal2",
+              1,
+              [](S &s, uint32_t) {
+                  if (rd(s.mode) != ROBOT_MODE::ROBOT_NO_FORCE) {
+                      wr(s.gimbalT_2_yaw_reletive,
+                         rd(s.gimbalT_2_yaw_set) - rd(s.gimbal_sentry_yaw) +
+                             rd(s.gimbalT_2_pitch_set));
+                  }
+              } },
+            { "gimbal_sentry",
+              1,
+              [](S &s, uint32_t i) {
+                  auto referee = s.referee_info.load();
+                  wr(s.gimbal_sentry_yaw_reletive,
+                     rd(s.gimbalT_1_yaw_reletive) + rd(s.gimbalT_2_yaw_reletive));
+                  wr(s.gimbal_sentry_yaw,
+                     rd(s.gimbal_sentry_yaw_set) + i * 1e-5f +
+                         referee.game_status_data.game_progress);
+              } },
+            { "chassis",
+              1,
+              [](S &s, uint32_t) {
+                  auto cap = s.super_cap_info.load();
+                  if (rd(s.mode) != ROBOT_MODE::ROBOT_NO_FORCE) {
+                      float yaw = rd(s.gimbalT_1_yaw_reletive) + rd(s.gimbal_sentry_yaw_reletive);
+                      float v = rd(s.vx_set) * yaw + rd(s.vy_set) + cap.chassisPower;
+                      wr(s.spin_state, rd(s.wz_set) > 0.1f && v == v);
+                  }
+              } },
+            { "shoot",
+              1,
+              [](S &s, uint32_t) {
+                  auto referee = s.referee_info.load();
+                  bool bullets = referee.bullet_allowance_data.bullet_allowance_num_17_mm > 0;
+                  wr(s.friction_real_state,
+                     rd(s.friction_open) && (rd(s.shoot_open) != 0 || bullets) &&
+                         rd(s.mode) != ROBOT_MODE::ROBOT_NO_FORCE);
+              } },
+            { "referee",
+              10,
+              [](S &s, uint32_t i) {
+                  s.referee_info.update([&](Types::Referee_info &info) {
+                      info.game_status_data.game_progress = 4;
+                      info.bullet_allowance_data.bullet_allowance_num_17_mm = i & 0xff;
+                  });
+                  auto cap = s.super_cap_info.load();
+                  wr(s.header,
+                     static_cast<uint8_t>(
+                         rd(s.friction_real_state) + rd(s.cv_fire) + rd(s.spin_state) +
+                         cap.capEnergy));
+              } },
+            { "super_cap",
+              10,
+              [](S &s, uint32_t i) {
+                  auto referee = s.referee_info.load();
+                  Types::ReceivePacket_Super_Cap cap{};
+                  cap.capEnergy = static_cast<uint8_t>(i);
+                  cap.chassisPower = referee.game_robot_status_data.robot_level;
+                  s.super_cap_info.store(cap);
+              } },
+        };
+    }
+
+    std::vector<Role<Robot::Robot_set>> partitioned_roles() {
+        using S = Robot::Robot_set;
+        using Types::ROBOT_MODE;
+        auto vision = [](Robot::VisionInput &input, uint32_t i) {
+            input.commands++;
+            input.yaw_set = i * 1e-4f;
+            input.pitch_set = i * -1e-4f;
+            input.firing = (i & 7) == 0;
+            input.stamp_ns = Robot::input_now_ns();
+        };
+        return {
+            { "rc",
+              4,
+              [](S &s, uint32_t i) {
+                  bool force = s.mode.load() != ROBOT_MODE::ROBOT_NO_FORCE;
+                  s.rc.update([&](Robot::RcInput &input) {
+                      input.packets++;
+                      input.vx_set = i * 1e-3f;
+                      input.vy_set = i * 2e-3f;
+                      input.wz_set = (i & 1) * 1.f;
+                      if (!input.auto_aim_status) {
+                          input.yaw_offset += 1e-4f;
+                      }
+                      input.friction_open = force;
+                      input.shoot_open = static_cast<int>(i & 1);
+                  });
+              } },
+            { "vision1",
+              2,
+              [vision](S &s, uint32_t i) {
+                  s.vision_gimbal1.update([&](Robot::VisionInput &input) { vision(input, i); });
+              } },
+            { "vision2",
+              2,
+              [vision](S &s, uint32_t i) {
+                  s.vision_gimbal2.update([&](Robot::VisionInput &input) { vision(input, i); });
+              } },
+            { "gimbal1",
+              1,
+              [](S &s, uint32_t) {
+                  auto in = s.inputs();
+                  if (in.mode() != ROBOT_MODE::ROBOT_NO_FORCE) {
+                      float sentry = s.gimbal_sentry_state.load().yaw;
+                      s.gimbalT_1_state.store(
+                          { 0.f,
+                            in.vision[0].yaw_set + in.rc.yaw_offset - sentry +
+                                in.vision[0].pitch_set });
+                  }
+              } },
+            { "gimbal2",
+              1,
+              [](S &s, uint32_t) {
+                  auto in = s.inputs();
+                  if (in.mode() != ROBOT_MODE::ROBOT_NO_FORCE) {
+                      float sentry = s.gimbal_sentry_state.load().yaw;
+                      s.gimbalT_2_state.store(
+                          { 0.f, in.vision[1].yaw_set - sentry + in.vision[1].pitch_set });
+                  }
+              } },
+            { "gimbal_sentry",
+              1,
+              [](S &s, uint32_t i) {
+                  auto in = s.inputs();
+                  auto referee = s.referee_info.load();
+                  float relative = s.gimbalT_1_state.load().yaw_relative +
+                                   s.gimbalT_2_state.load().yaw_relative;
+                  s.gimbal_sentry_state.store(
+                      { in.rc.yaw_offset + i * 1e-5f + referee.game_status_data.game_progress,
+                        relative });
+              } },
+            { "chassis",
+              1,
+              [](S &s, uint32_t) {
+                  auto in = s.inputs();
+                  auto cap = s.super_cap_info.load();
+                  if (in.mode() != ROBOT_MODE::ROBOT_NO_FORCE) {
+                      float yaw = s.gimbalT_1_state.load().yaw_relative +
+                                  s.gimbal_sentry_state.load().yaw_relative;
+                      float v = in.rc.vx_set * yaw + in.rc.vy_set + cap.chassisPower;
+                      wr(s.spin_state, in.wz_set() > 0.1f && v == v);
+                  }
+              } },
+            { "shoot",
+              1,
+              [](S &s, uint32_t) {
+                  auto in = s.inputs();
+                  auto referee = s.referee_info.load();
+                  bool bullets = referee.bullet_allowance_data.bullet_allowance_num_17_mm > 0;
+                  wr(s.friction_real_state,
+                     in.friction_open() && (in.shoot_open() != 0 || bullets) &&
+                         in.mode() != ROBOT_MODE::ROBOT_NO_FORCE);
+              } },
+            { "referee",
+              10,
+              [](S &s, uint32_t i) {
+                  s.referee_info.update([&](Types::Referee_info &info) {
+                      info.game_status_data.game_progress = 4;
+                      info.bullet_allowance_data.bullet_allowance_num_17_mm = i & 0xff;
+                  });
+                  auto cap = s.super_cap_info.load();
+                  wr(s.header,
+                     static_cast<uint8_t>(
+                         rd(s.friction_real_state) + s.inputs().cv_fire() + rd(s.spin_state) +
+                         cap.capEnergy));
+              } },
+            { "super_cap",
+              10,
+              [](S &s, uint32_t i) {
+                  auto referee = s.referee_info.load();
+                  Types::ReceivePacket_Super_Cap cap{};
+                  cap.capEnergy = static_cast<uint8_t>(i);
+                  cap.chassisPower = referee.game_robot_status_data.robot_level;
+                  s.super_cap_info.store(cap);
+              } },
+        };
+    }
+
+    volatile uint64_t sink = 0;
+
+    uint64_t work(uint64_t x, int n) {
+        for (int i = 0; i < n; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        return x;
+    }
+
+    template<typename S>
+    std::vector<Result> soak(std::vector<Role<S>> list, double seconds, int work_per_tick) {
+        auto set = std::make_unique<S>();
+        set->mode = Types::ROBOT_MODE::ROBOT_FOLLOW_GIMBAL;
+        std::vector<Result> results(list.size());
+        std::atomic<size_t> ready = 0;
+        std::atomic<bool> go = false;
+        std::atomic<bool> stop = false;
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        std::vector<std::thread> threads;
+        for (size_t r = 0; r < list.size(); r++) {
+            threads.emplace_back([&, r] {
+                cpu_set_t set_cpu;
+                CPU_ZERO(&set_cpu);
+                CPU_SET(static_cast<int>(r % cpus), &set_cpu);
+                pthread_setaffinity_np(pthread_self(), sizeof(set_cpu), &set_cpu);
+
+                auto &role = list[r];
+                Counter misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+                Counter l1d(
+                    PERF_TYPE_HW_CACHE,
+                    PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                        PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                ready++;
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+
+                uint64_t x = r + 1;
+                uint32_t ticks = 0;
+                auto start = std::chrono::steady_clock::now();
+                misses.start();
+                l1d.start();
+                while (!stop.load(std::memory_order_relaxed)) {
+                    role.tick(*set, ticks++);
+                    x = work(x, work_per_tick * role.slow);
+                }
+                auto &result = results[r];
+                result.l1d_misses = l1d.stop();
+                result.cache_misses = misses.stop();
+                result.ns = std::chrono::duration<double, std::nano>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+                result.name = role.name;
+                result.ticks = ticks;
+                sink = sink + x;
+            });
+        }
+        while (ready.load() < list.size()) {
+            std::this_thread::yield();
+        }
+        go.store(true, std::memory_order_release);
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        return results;
+    }
+
+    void print(const char *layout, size_t size, const std::vector<Result> &results) {
+        std::printf("%s layout, %zu bytes\n", layout, size);
+        std::printf(
+            "  %-14s %12s %10s %16s %14s\n",
+            "thread",
+            "ticks",
+            "ns/tick",
+            "cache-miss/tick",
+            "L1D-miss/tick");
+        uint64_t ticks = 0;
+        int64_t misses = 0;
+        int64_t l1d = 0;
+        for (const auto &result : results) {
+            auto per_tick = [&](int64_t count) {
+                return count < 0 ? -1. : static_cast<double>(count) / result.ticks;
+            };
+            std::printf(
+                "  %-14s %12lu %10.1f %16.3f %14.3f\n",
+                result.name,
+                result.ticks,
+                result.ns / result.ticks,
+                per_tick(result.cache_misses),
+                per_tick(result.l1d_misses));
+            ticks += result.ticks;
+            misses = result.cache_misses < 0 || misses < 0 ? -1 : misses + result.cache_misses;
+            l1d = result.l1d_misses < 0 || l1d < 0 ? -1 : l1d + result.l1d_misses;
+        }
+        std::printf(
+            "  %-14s %12lu %10s %16.3f %14.3f\n\n",
+            "total",
+            ticks,
+            "",
+            misses < 0 ? -1. : static_cast<double>(misses) / ticks,
+            l1d < 0 ? -1. : static_cast<double>(l1d) / ticks);
+    }
+}  // namespace
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? std::strtod(argv[1], nullptr) : 3.;
+    int work_per_tick = argc > 2 ? std::atoi(argv[2]) : 16;
+
+    std::printf(
+        "robot_set_bench: %.1fs per layout, work %d, %ld cpus online "
+        "(-1 = counter unavailable)\n\n",
+        seconds,
+        work_per_tick,
+        sysconf(_SC_NPROCESSORS_ONLN));
+    print("packed", sizeof(PackedSet), soak(packed_roles(), seconds, work_per_tick));
+    print(
+        "partitioned",
+        sizeof(Robot::Robot_set),
+        soak(partitioned_roles(), seconds, work_per_tick));
+    return 0;
+}
@@ -0,0 +1,345 @@
+// Stand-in for the IMU/RC board: streams ReceivePacket_IMU/RC_CTRL frames over a PTY so
+// Serial_interface, Device::IMU and Device::Rc_Controller run without /dev/IMU_*. Point
+// Config::SerialInitList (or CONFIG_SIM's IMU_SERIAL) at the --pty path.
+//
+//   ./build/tools/serial_emu --imu-hz 2000 --corrupt 0.01 --drop 0.01 --duration 10
+//
+// options:
+//   --pty path              PTY symlink (/tmp/gkd_sim/IMU)
+//   --imu-hz n / --rc-hz n  packet rates, IMU up to 2000 (1000 / 70)
+//   --framing legacy|v2     frame format (v2)
+//   --play file             replay a raw capture of the board (`cat /dev/IMU_HERO > file`) instead
+//                           of the synthetic stream, one IMU packet per tick, looped
+//   --no-keys               synthetic RC holds every key released after the init gesture
+//   --corrupt p             flip one bit in a frame with probability p
+//   --drop p                skip a frame with probability p (a V2 sequence gap)
+//   --garbage p             insert 1..8 random bytes before a frame with probability p
+//   --stall every_ms:ms     go silent for ms every every_ms
+//   --seed n                random seed for the injections (1)
+//   --duration s            exit after s seconds, 0 runs until SIGINT
+//
+// The synthetic stream sweeps yaw/pitch as slow sines, sends the Rc_Controller init gesture
+// (both switches down, wheel rolled up) for the first second and then holds W A S D R F in turn
+// for half a second each.
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pty_link.hpp"
+#include "serial_protocol.hpp"
+#include "types.hpp"
+
+namespace
+{
+    namespace Proto = IO::SerialProtocol;
+
+    // same values as rc_controller.hpp
+    constexpr int S_DOWN = 2;
+    constexpr int ROLL_UP_MAX = -660;
+    constexpr int KEYS[] = { 0x8, 0x2, 0x4, 0x1, 0x40, 0x80 };  // W A S D R F
+
+    constexpr int MAX_IMU_HZ = 2000;
+
+    std::atomic<bool> running = true;
+
+    void on_signal(int) {
+        running = false;
+    }
+
+    void sleep_until(timespec &next, long period_ns) {
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+
+    double seconds_since(const timespec &start) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+    }
+
+    struct Packet
+    {
+        uint8_t id;
+        std::vector<uint8_t> payload;
+    };
+
+    // cuts legacy and V2 frames out of a raw capture, V2 frames with a bad crc are skipped
+    std::vector<Packet> load_capture(const std::string &path) {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            perror(path.c_str());
+            exit(-1);
+        }
+        std::vector<uint8_t> raw;
+        uint8_t chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            raw.insert(raw.end(), chunk, chunk + n);
+        }
+        fclose(file);
+
+        std::vector<Packet> packets;
+        size_t i = 0;
+        while (i + 2 < raw.size()) {
+            const uint8_t *p = raw.data() + i;
+            size_t avail = raw.size() - i;
+            if (p[0] == Proto::V2_SOF0 && p[1] == Proto::V2_SOF1 && avail >= Proto::V2_HEAD) {
+                size_t len = Proto::payload_size(p[3]);
+                size_t total = Proto::V2_HEAD + len + Proto::V2_TAIL;
+                if (p[2] == Proto::V2_VERSION && len != 0 && p[4] == len && avail >= total) {
+                    uint16_t crc = Referee::crc16(p, Proto::V2_HEAD + len);
+                    if (p[total - 2] == (crc & 0xff) && p[total - 1] == (crc >> 8)) {
+                        packets.push_back(
+                            { p[3], { p + Proto::V2_HEAD, p + Proto::V2_HEAD + len } });
+                        i += total;
+                        continue;
+                    }
+                }
+            }
+            if (p[0] == Proto::LEGACY_SOF0 && p[1] == Proto::LEGACY_SOF1) {
+                size_t len = Proto::payload_size(p[2]);
+                if (len != 0 && avail >= Proto::LEGACY_HEAD + len) {
+                    packets.push_back(
+                        { p[2], { p + Proto::LEGACY_HEAD, p + Proto::LEGACY_HEAD + len } });
+                    i += Proto::LEGACY_HEAD + len;
+                    continue;
+                }
+            }
+            i++;
+        }
+        if (std::none_of(packets.begin(), packets.end(), [](const Packet &packet) {
+                return packet.id == Proto::IMU_ID;
+            })) {
+            fprintf(stderr, "%s: no IMU frames found\n", path.c_str());
+            exit(-1);
+        }
+        return packets;
+    }
+
+    struct Options
+    {
+        std::string link = "/tmp/gkd_sim/IMU";
+        int imu_hz = 1000;
+        int rc_hz = 70;
+        bool v2 = true;
+        std::string play;
+        bool keys = true;
+        double corrupt = 0;
+        double drop = 0;
+        double garbage = 0;
+        int stall_every_ms = 0;
+        int stall_ms = 0;
+        unsigned seed = 1;
+        double duration = 0;
+    };
+
+    struct Stats
+    {
+        uint64_t imu = 0;
+        uint64_t rc = 0;
+        uint64_t bytes = 0;
+        uint64_t corrupted = 0;
+        uint64_t dropped = 0;
+        uint64_t garbage_bytes = 0;
+        uint64_t stalls = 0;
+        uint64_t overruns = 0;  // nobody drained the PTY
+    };
+
+    class Emitter
+    {
+       public:
+        Emitter(const Options &options, Tools::PtyLink &pty)
+            : options(options),
+              pty(pty),
+              random(options.seed) {
+        }
+
+        void send(uint8_t id, const void *payload, size_t len) {
+            uint8_t &seq = id == Proto::IMU_ID ? imu_seq : rc_seq;
+            if (chance(options.drop)) {
+                seq++;
+                stats.dropped++;
+                return;
+            }
+            uint8_t buf[Proto::MAX_FRAME + 8];
+            size_t n = 0;
+            if (chance(options.garbage)) {
+                n = 1 + random() % 8;
+                for (size_t i = 0; i < n; i++) {
+                    buf[i] = random();
+                }
+                stats.garbage_bytes += n;
+            }
+            size_t frame = options.v2 ? Proto::encode_v2(id, seq++, payload, len, buf + n)
+                                      : Proto::encode_legacy(id, payload, len, buf + n);
+            if (chance(options.corrupt)) {
+                buf[n + random() % frame] ^= 1 << (random() % 8);
+                stats.corrupted++;
+            }
+            n += frame;
+            if (pty.write_all(buf, n)) {
+                stats.bytes += n;
+                (id == Proto::IMU_ID ? stats.imu : stats.rc)++;
+            } else {
+                stats.overruns++;
+            }
+        }
+
+        Stats stats;
+
+       private:
+        bool chance(double p) {
+            return p > 0 && std::uniform_real_distribution<double>(0, 1)(random) < p;
+        }
+
+        const Options &options;
+        Tools::PtyLink &pty;
+        std::mt19937 random;
+        uint8_t imu_seq = 0;
+        uint8_t rc_seq = 0;
+    };
+
+    void synthetic_tick(Emitter &emitter, const Options &options, uint64_t tick) {
+        double t = static_cast<double>(tick) / options.imu_hz;
+        Types::ReceivePacket_IMU imu{};
+        imu.yaw = 90 * std::sin(0.5 * t);
+        imu.pitch = 10 * std::sin(1.3 * t);
+        imu.yaw_v = 45 * std::cos(0.5 * t);
+        imu.pitch_v = 13 * std::cos(1.3 * t);
+        emitter.send(Proto::IMU_ID, &imu, sizeof(imu));
+
+        int rc_every = std::max(options.imu_hz / std::max(options.rc_hz, 1), 1);
+        if (options.rc_hz > 0 && tick % rc_every == 0) {
+            Types::ReceivePacket_RC_CTRL rc{};
+            rc.s1 = S_DOWN;
+            rc.s2 = S_DOWN;
+            if (t < 1) {
+                rc.ch4 = ROLL_UP_MAX;
+            } else if (options.keys) {
+                size_t slot = static_cast<size_t>((t - 1) * 2) % (std::size(KEYS) + 1);
+                rc.key = slot < std::size(KEYS) ? KEYS[slot] : 0;
+            }
+            emitter.send(Proto::RC_ID, &rc, sizeof(rc));
+        }
+    }
+
+    // sends recorded packets up to and including the next IMU one
+    void playback_tick(Emitter &emitter, const std::vector<Packet> &packets, size_t &cursor) {
+        while (true) {
+            const auto &packet = packets[cursor];
+            cursor = (cursor + 1) % packets.size();
+            emitter.send(packet.id, packet.payload.data(), packet.payload.size());
+            if (packet.id == Proto::IMU_ID) {
+                return;
+            }
+        }
+    }
+
+    const char *arg_value(int &i, int argc, char **argv) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "%s needs a value\n", argv[i]);
+            exit(-1);
+        }
+        return argv[++i];
+    }
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--pty") {
+            options.link = arg_value(i, argc, argv);
+        } else if (arg == "--imu-hz") {
+            options.imu_hz = std::clamp(atoi(arg_value(i, argc, argv)), 1, MAX_IMU_HZ);
+        } else if (arg == "--rc-hz") {
+            options.rc_hz = atoi(arg_value(i, argc, argv));
+        } else if (arg == "--framing") {
+            options.v2 = std::string(arg_value(i, argc, argv)) != "legacy";
+        } else if (arg == "--play") {
+            options.play = arg_value(i, argc, argv);
+        } else if (arg == "--no-keys") {
+            options.keys = false;
+        } else if (arg == "--corrupt") {
+            options.corrupt = atof(arg_value(i, argc, argv));
+        } else if (arg == "--drop") {
+            options.drop = atof(arg_value(i, argc, argv));
+        } else if (arg == "--garbage") {
+            options.garbage = atof(arg_value(i, argc, argv));
+        } else if (arg == "--stall") {
+            const char *value = arg_value(i, argc, argv);
+            if (sscanf(value, "%d:%d", &options.stall_every_ms, &options.stall_ms) != 2) {
+                fprintf(stderr, "--stall wants every_ms:ms, got %s\n", value);
+                return -1;
+            }
+        } else if (arg == "--seed") {
+            options.seed = strtoul(arg_value(i, argc, argv), nullptr, 0);
+        } else if (arg == "--duration") {
+            options.duration = atof(arg_value(i, argc, argv));
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return -1;
+        }
+    }
+
+    std::vector<Packet> packets;
+    if (!options.play.empty()) {
+        packets = load_capture(options.play);
+        printf("%s: %zu packet(s)\n", options.play.c_str(), packets.size());
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    Tools::PtyLink pty(options.link);
+    Emitter emitter(options, pty);
+    long period_ns = 1000000000L / options.imu_hz;
+    size_t cursor = 0;
+    timespec start, next;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    next = start;
+    double next_stall = options.stall_every_ms / 1e3;
+    double stall_until = 0;
+    for (uint64_t tick = 0; running; tick++) {
+        double now = seconds_since(start);
+        if (options.duration > 0 && now > options.duration) {
+            break;
+        }
+        if (options.stall_every_ms > 0 && now >= next_stall) {
+            stall_until = now + options.stall_ms / 1e3;
+            next_stall += options.stall_every_ms / 1e3;
+            emitter.stats.stalls++;
+        }
+        if (now >= stall_until) {
+            if (packets.empty()) {
+                synthetic_tick(emitter, options, tick);
+            } else {
+                playback_tick(emitter, packets, cursor);
+            }
+        }
+        sleep_until(next, period_ns);
+    }
+
+    const auto &s = emitter.stats;
+    double elapsed = seconds_since(start);
+    printf("%.2fs: %lu imu (%.0f/s), %lu rc, %lu byte(s), %lu corrupted, %lu dropped, "
+           "%lu garbage byte(s), %lu stall(s), %lu overrun(s)\n",
+           elapsed, s.imu, s.imu / elapsed, s.rc, s.bytes, s.corrupted, s.dropped,
+           s.garbage_bytes, s.stalls, s.overruns);
+    return 0;
+}
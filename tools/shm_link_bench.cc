@@ -0,0 +1,132 @@
+// Round trip of a SendAutoAimInfo-sized message between two processes: UDP on 127.0.0.1 (what
+// Server_socket_interface does without shm) versus the ShmLink rings, with the echoing side
+// sleeping on its futex doorbell between messages.
+//
+//   make tools && ./build/tools/shm_link_bench [round trips]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "histogram.hpp"
+#include "robot.hpp"
+#include "shm_link.hpp"
+
+namespace
+{
+    constexpr uint8_t HEADER = 0x6A;
+    constexpr int UDP_ROBOT_PORT = 11461;
+    constexpr int UDP_VISION_PORT = 11462;
+    constexpr const char *SHM_NAME = "/gkd_shm_link_bench";
+
+    using Clock = std::chrono::steady_clock;
+
+    sockaddr_in local(int port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        addr.sin_port = htons(port);
+        return addr;
+    }
+
+    int udp_socket(int port) {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        auto addr = local(port);
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+            perror("bind");
+            exit(-1);
+        }
+        return fd;
+    }
+
+    void send_to(int fd, const void *data, size_t len, const sockaddr_in &to) {
+        sendto(fd, data, len, 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+    }
+
+    void report(const char *name, const UserLib::Histogram &rtt) {
+        printf("%-6s rtt p50 %7.2f us  p99 %7.2f us  max %8.2f us\n",
+               name, rtt.percentile(0.5) / 1e3, rtt.percentile(0.99) / 1e3, rtt.max() / 1e3);
+    }
+
+    void bench_udp(int rounds) {
+        if (fork() == 0) {
+            int fd = udp_socket(UDP_VISION_PORT);
+            auto robot = local(UDP_ROBOT_PORT);
+            Robot::SendAutoAimInfo pkg;
+            for (int i = 0; i < rounds; i++) {
+                recv(fd, &pkg, sizeof(pkg), 0);
+                send_to(fd, &pkg, sizeof(pkg), robot);
+            }
+            _exit(0);
+        }
+        int fd = udp_socket(UDP_ROBOT_PORT);
+        auto vision = local(UDP_VISION_PORT);
+        usleep(100000);
+        UserLib::Histogram rtt;
+        Robot::SendAutoAimInfo pkg{};
+        pkg.header = HEADER;
+        for (int i = 0; i < rounds; i++) {
+            auto start = Clock::now();
+            send_to(fd, &pkg, sizeof(pkg), vision);
+            recv(fd, &pkg, sizeof(pkg), 0);
+            rtt.record(std::chrono::nanoseconds(Clock::now() - start).count());
+        }
+        wait(nullptr);
+        close(fd);
+        report("udp", rtt);
+    }
+
+    void bench_shm(int rounds) {
+        IO::ShmLink robot;
+        if (!robot.open(SHM_NAME, IO::ShmLink::Side::ROBOT)) {
+            exit(-1);
+        }
+        if (fork() == 0) {
+            IO::ShmLink vision;
+            vision.open(SHM_NAME, IO::ShmLink::Side::VISION);
+            auto ring = vision.tx_ring(HEADER);
+            for (int i = 0; i < rounds;) {
+                size_t n = vision.poll([&](const uint8_t *data, uint32_t len) {
+                    vision.send(ring, data, len);
+                });
+                if (n == 0) {
+                    vision.wait(std::chrono::milliseconds(100));
+                }
+                i += n;
+            }
+            _exit(0);
+        }
+        auto ring = robot.tx_ring(HEADER);
+        usleep(100000);
+        UserLib::Histogram rtt;
+        Robot::SendAutoAimInfo pkg{};
+        pkg.header = HEADER;
+        for (int i = 0; i < rounds; i++) {
+            auto start = Clock::now();
+            robot.send(ring, &pkg, sizeof(pkg));
+            while (robot.poll([&](const uint8_t *, uint32_t) {}) == 0) {
+                robot.wait(std::chrono::milliseconds(100));
+            }
+            rtt.record(std::chrono::nanoseconds(Clock::now() - start).count());
+        }
+        wait(nullptr);
+        shm_unlink(SHM_NAME);
+        report("shm", rtt);
+    }
+}  // namespace
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 100000;
+    printf("%d round trips of %zu bytes\n", rounds, sizeof(Robot::SendAutoAimInfo));
+    bench_udp(rounds);
+    bench_shm(rounds);
+    return 0;
+}
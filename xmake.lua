@@ -6,9 +6,14 @@ option("type")
     set_default("infantry")
     set_showmenu(true)
     set_description("指定要编译的机器人类型")
-    set_values("infantry","hero","sentry")
+    set_values("infantry","hero","sentry","sim")
     after_check(function(option)
-        option:add("defines", "CONFIG_" .. string.upper(option:value()))
+        -- sim: 步兵配置跑在 vcan 和 PTY 上，配合 plant_sim 使用
+        if option:value() == "sim" then
+            option:add("defines", "CONFIG_INFANTRY", "CONFIG_SIM")
+        else
+            option:add("defines", "CONFIG_" .. string.upper(option:value()))
+        end
         option:set("basename",option:value())
     end)
 
@@ -41,4 +46,51 @@ target("GKDControl")
 
     if(is_mode("debug")) then 
         add_defines("__DEBUG__")
-    end
\ No newline at end of file
+    end
+
+target("callback_key_bench")
+    set_kind("binary")
+    set_default(false)
+    set_languages("c++23")
+    set_optimize("fastest")
+    add_files("tools/callback_key_bench.cc")
+    add_includedirs("include/io", "include/utils")
+
+target("plant_sim")
+    set_kind("binary")
+    set_default(false)
+    set_languages("c++23")
+    set_optimize("fastest")
+    add_files("tools/plant_sim.cc")
+    add_includedirs("tools", "include/io", "include/utils", "include/device/referee")
+
+target("serial_emu")
+    set_kind("binary")
+    set_default(false)
+    set_languages("c++23")
+    set_optimize("fastest")
+    add_files("tools/serial_emu.cc")
+    add_includedirs("tools", "include/io", "include/utils", "include/device/referee")
+
+target("shm_link_bench")
+    set_kind("binary")
+    set_default(false)
+    set_languages("c++23")
+    set_optimize("fastest")
+    add_files("tools/shm_link_bench.cc", "src/io/shm_link.cc")
+    add_includedirs("include", "include/io", "include/utils", "include/device/referee")
+
+target("robot_set_bench")
+    set_kind("binary")
+    set_default(false)
+    set_languages("c++23")
+    set_optimize("fastest")
+    add_files("tools/robot_set_bench.cc")
+    add_includedirs("include", "include/io", "include/utils", "include/device/referee")
+
+target("can_trace_tool")
+    set_kind("binary")
+    set_default(false)
+    set_languages("c++23")
+    add_files("tools/can_trace_tool.cc", "src/io/can_trace.cc")
+    add_includedirs("include/io", "include/utils")